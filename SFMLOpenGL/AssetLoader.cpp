@@ -0,0 +1,445 @@
+#include <AssetLoader.h>
+#include <Debug.h>
+#include <Trace.h>
+
+#include <SFML/Window.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+AssetLoader::AssetLoader(unsigned t_workers) :
+	m_workerCount{ std::max(1u, t_workers) },
+	m_nextId{ 0 },
+	m_issued{ 0 },
+	m_running{ false },
+	m_stopping{ false }
+{
+}
+
+/////////////////////////////////////////////////////////
+
+AssetLoader::~AssetLoader()
+{
+	// Without a context to release them into, objects still in flight are left to the driver
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_decodeReady.notify_all();
+	m_uploadReady.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	if (m_uploader.joinable()) m_uploader.join();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Starts the worker threads and the upload thread. The upload thread's
+/// context is created shared with whichever context is active here.
+/// </summary>
+void AssetLoader::start()
+{
+	if (m_running) return;
+
+	m_stopping = false;
+	m_running = true;
+
+	for (unsigned i = 0; i < m_workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&AssetLoader::decodeLoop, this));
+	}
+	m_uploader = std::thread(&AssetLoader::uploadLoop, this);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Stops the threads. Assets that were uploaded but not yet handed over are
+/// adopted by t_resources and released straight away, so nothing leaks.
+/// </summary>
+void AssetLoader::stop(GLResources& t_resources)
+{
+	if (!m_running) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_decodeReady.notify_all();
+	m_uploadReady.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+	m_uploader.join();
+
+	for (std::unique_ptr<Request>& request : m_fenced)
+	{
+		glClientWaitSync(request->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		glDeleteSync(request->fence);
+
+		if (request->program) t_resources.adoptProgram(request->program);
+		if (request->vertexBuffer) t_resources.adoptBuffer(request->vertexBuffer, 0);
+		if (request->indexBuffer) t_resources.adoptBuffer(request->indexBuffer, 0);
+	}
+
+	m_decodeQueue.clear();
+	m_uploadQueue.clear();
+	m_fenced.clear();
+	m_nextId = m_issued;
+	m_running = false;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Reads, compiles and links a program with the standard attribute locations
+/// </summary>
+/// <param name="t_onReady">receives the linked program, or an empty one if it failed</param>
+void AssetLoader::loadProgram(const std::string& t_vertexPath, const std::string& t_fragmentPath, ProgramCallback t_onReady)
+{
+	std::unique_ptr<Request> request(new Request());
+	request->type = PROGRAM_REQUEST;
+	request->vertexPath = t_vertexPath;
+	request->fragmentPath = t_fragmentPath;
+	request->onProgram = t_onReady;
+
+	enqueue(std::move(request));
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Decodes a mesh on a worker and uploads it into two staging buffers
+/// </summary>
+/// <param name="t_decoder">fills MeshData; must not touch GL</param>
+/// <param name="t_onReady">receives the buffers, or empty ones if decoding failed</param>
+void AssetLoader::loadMesh(MeshDecoder t_decoder, MeshCallback t_onReady)
+{
+	std::unique_ptr<Request> request(new Request());
+	request->type = MESH_REQUEST;
+	request->decoder = t_decoder;
+	request->onMesh = t_onReady;
+
+	enqueue(std::move(request));
+}
+
+/////////////////////////////////////////////////////////
+
+void AssetLoader::enqueue(std::unique_ptr<Request> t_request)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		t_request->id = m_issued++;
+		m_decodeQueue.push_back(std::move(t_request));
+	}
+	m_decodeReady.notify_one();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Hands over every asset whose upload the GPU has finished, without waiting.
+/// Call once per frame on the render thread.
+/// </summary>
+void AssetLoader::poll(GLResources& t_resources)
+{
+	TRACE_SCOPE("AssetLoader::poll", "gl");
+
+	while (deliver(t_resources, false))
+	{
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Waits for every request so far, for callers that need all assets before drawing
+/// </summary>
+void AssetLoader::finish(GLResources& t_resources)
+{
+	while (m_running && getPending() > 0)
+	{
+		deliver(t_resources, true);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+unsigned AssetLoader::getPending() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_issued - m_nextId;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Hands over the next asset in request order if it has been uploaded and its fence has signalled.
+/// If the wait fails the callback gets empty objects, as it does when loading fails.
+/// </summary>
+/// <returns>true if an asset was handed over</returns>
+bool AssetLoader::deliver(GLResources& t_resources, bool t_wait)
+{
+	std::unique_ptr<Request> request;
+
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		std::vector<std::unique_ptr<Request>>::iterator next;
+		for (;;)
+		{
+			next = std::find_if(m_fenced.begin(), m_fenced.end(),
+				[this](const std::unique_ptr<Request>& t_request) { return t_request->id == m_nextId; });
+
+			if (next != m_fenced.end() || !t_wait || m_stopping) break;
+			m_uploaded.wait(lock);
+		}
+
+		if (next == m_fenced.end())
+		{
+			return false;
+		}
+
+		// Only this thread delivers, so the request can wait outside the lock
+		request = std::move(*next);
+		m_fenced.erase(next);
+	}
+
+	GLenum status = glClientWaitSync(request->fence, t_wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, t_wait ? 1000000000 : 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_fenced.push_back(std::move(request));
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_nextId++;
+	}
+
+	glDeleteSync(request->fence);
+
+	// The objects may never have been finished, so fail the request rather than hand them over
+	if (status == GL_WAIT_FAILED)
+	{
+		DEBUG_MSG("ERROR: Waiting on an asset fence failed, dropping request " + std::to_string(request->id));
+		if (request->program) glDeleteProgram(request->program);
+		if (request->vertexBuffer) glDeleteBuffers(1, &request->vertexBuffer);
+		if (request->indexBuffer) glDeleteBuffers(1, &request->indexBuffer);
+		request->program = request->vertexBuffer = request->indexBuffer = 0;
+	}
+
+	if (request->type == PROGRAM_REQUEST)
+	{
+		GLProgram program;
+		if (request->program) program = t_resources.adoptProgram(request->program);
+		if (request->onProgram) request->onProgram(program);
+	}
+	else
+	{
+		GLBuffer vertices, indices;
+		if (request->vertexBuffer) vertices = t_resources.adoptBuffer(request->vertexBuffer, sizeof(Vertex) * request->mesh.vertices.size());
+		if (request->indexBuffer) indices = t_resources.adoptBuffer(request->indexBuffer, Mesh::indexSize(request->mesh.indexType) * request->mesh.numIndices);
+		if (request->onMesh) request->onMesh(vertices, indices, request->mesh);
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Worker thread: file reads and mesh decoding, nothing that needs GL
+/// </summary>
+void AssetLoader::decodeLoop()
+{
+	TRACE_THREAD_NAME("asset decode");
+
+	for (;;)
+	{
+		std::unique_ptr<Request> request;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_decodeReady.wait(lock, [this] { return m_stopping || !m_decodeQueue.empty(); });
+			if (m_stopping) return;
+
+			request = std::move(m_decodeQueue.front());
+			m_decodeQueue.pop_front();
+		}
+
+		TRACE_SCOPE(request->type == PROGRAM_REQUEST ? "read shaders" : "decode mesh", "job");
+
+		if (request->type == PROGRAM_REQUEST)
+		{
+			request->ok = readFile(request->vertexPath, request->vertexSource)
+				&& readFile(request->fragmentPath, request->fragmentSource);
+		}
+		else
+		{
+			request->ok = request->decoder && request->decoder(request->mesh);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_uploadQueue.push_back(std::move(request));
+		}
+		m_uploadReady.notify_one();
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Upload thread: owns a context shared with the window's, and fences every
+/// asset it creates so the render thread knows when it is safe to use
+/// </summary>
+void AssetLoader::uploadLoop()
+{
+	// SFML shares every context it creates, and activates this one on this thread
+	sf::Context context;
+	TRACE_THREAD_NAME("asset upload");
+
+	for (;;)
+	{
+		std::unique_ptr<Request> request;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_uploadReady.wait(lock, [this] { return m_stopping || !m_uploadQueue.empty(); });
+			if (m_stopping) break;
+
+			request = std::move(m_uploadQueue.front());
+			m_uploadQueue.pop_front();
+		}
+
+		if (request->ok)
+		{
+			upload(*request);
+		}
+
+		// Flushed so the render thread's context can see the fence
+		request->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_fenced.push_back(std::move(request));
+		}
+		m_uploaded.notify_all();
+	}
+
+	m_uploaded.notify_all();
+}
+
+/////////////////////////////////////////////////////////
+
+void AssetLoader::upload(Request& t_request)
+{
+	TRACE_SCOPE("AssetLoader::upload", "job");
+
+	if (t_request.type == PROGRAM_REQUEST)
+	{
+		GLuint vertexShader = compileShader(GL_VERTEX_SHADER, t_request.vertexSource, t_request.vertexPath);
+		GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, t_request.fragmentSource, t_request.fragmentPath);
+
+		GLuint program = glCreateProgram();
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+
+		// Fix attribute locations so mesh VAOs work with any program
+		glBindAttribLocation(program, POSITION_LOCATION, "sv_position");
+		glBindAttribLocation(program, COLOR_LOCATION, "sv_color");
+
+		glLinkProgram(program);
+
+		// Shaders are only needed until linked
+		glDetachShader(program, vertexShader);
+		glDetachShader(program, fragmentShader);
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+
+		GLint isLinked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+
+		if (isLinked)
+		{
+			DEBUG_MSG("Shader Linked: " + t_request.vertexPath + " + " + t_request.fragmentPath);
+			t_request.program = program;
+		}
+		else
+		{
+			DEBUG_MSG("ERROR: Shader Link Error: " + t_request.vertexPath + " + " + t_request.fragmentPath);
+			glDeleteProgram(program);
+		}
+	}
+	else
+	{
+		const MeshData& mesh = t_request.mesh;
+
+		// This context has no state cache; binds here never touch the render thread's
+		GLuint buffers[2];
+		glGenBuffers(2, buffers);
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+		glBufferData(GL_COPY_WRITE_BUFFER, sizeof(Vertex) * mesh.vertices.size(), mesh.vertices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+		glBufferData(GL_COPY_WRITE_BUFFER, Mesh::indexSize(mesh.indexType) * mesh.numIndices, mesh.indices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		t_request.vertexBuffer = buffers[0];
+		t_request.indexBuffer = buffers[1];
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <returns>false if the file could not be opened</returns>
+bool AssetLoader::readFile(const std::string& t_path, std::string& t_dest)
+{
+	std::ifstream inputStream{ t_path };
+
+	if (!inputStream.is_open())
+	{
+		DEBUG_MSG("ERROR while opening shader file: " + t_path);
+		return false;
+	}
+
+	t_dest.clear();
+
+	std::string line;
+	while (std::getline(inputStream, line))
+	{
+		t_dest += line + "\n";
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+GLuint AssetLoader::compileShader(GLenum t_type, const std::string& t_source, const std::string& t_path)
+{
+	const char* source = t_source.c_str();
+
+	GLuint shader = glCreateShader(t_type);
+	glShaderSource(shader, 1, (const GLchar**)&source, NULL);
+	glCompileShader(shader);
+
+	GLint isCompiled = 0;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
+
+	if (isCompiled != GL_TRUE)
+	{
+		DEBUG_MSG("ERROR: Shader Compilation Error: " + t_path);
+	}
+
+	return shader;
+}
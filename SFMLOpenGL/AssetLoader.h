@@ -0,0 +1,115 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <GL/glew.h>
+#include <GLResources.h>
+#include <Mesh.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Geometry produced by a mesh decoder, ready to upload
+/// </summary>
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned char> indices; // raw index data of indexType
+	GLsizei numIndices = 0;
+	GLenum indexType = GL_UNSIGNED_SHORT;
+};
+
+/// <summary>
+/// Loads programs and meshes off the render thread.
+///
+/// Worker threads read shader files and run mesh decoders. A single upload
+/// thread with its own GL context, shared with the window's, then compiles
+/// and links programs and fills buffers, and fences each finished asset.
+/// poll() runs on the render thread: once an asset's fence has signalled,
+/// its objects are handed to GLResources and its callback runs. Vertex
+/// arrays are not shared between contexts, so meshes arrive as a pair of
+/// staging buffers for the callback to copy into a GeometryPool or wrap in a VAO.
+/// </summary>
+class AssetLoader
+{
+public:
+	typedef std::function<bool(MeshData&)> MeshDecoder; // runs on a worker; false on failure
+	typedef std::function<void(GLProgram&)> ProgramCallback;
+	typedef std::function<void(GLBuffer& t_vertices, GLBuffer& t_indices, const MeshData& t_info)> MeshCallback;
+
+	explicit AssetLoader(unsigned t_workers = 2);
+	~AssetLoader();
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// Call with the window's context active on this thread
+	void start();
+	void stop(GLResources& t_resources);
+
+	// Callbacks run on the render thread, from poll(), in request order
+	void loadProgram(const std::string& t_vertexPath, const std::string& t_fragmentPath, ProgramCallback t_onReady);
+	void loadMesh(MeshDecoder t_decoder, MeshCallback t_onReady);
+
+	void poll(GLResources& t_resources);
+	void finish(GLResources& t_resources); // blocks until every request has been handed over
+
+	unsigned getPending() const;
+
+private:
+	enum RequestType
+	{
+		PROGRAM_REQUEST,
+		MESH_REQUEST
+	};
+
+	struct Request
+	{
+		unsigned id;
+		RequestType type;
+		bool ok = true;
+
+		std::string vertexPath, fragmentPath;
+		std::string vertexSource, fragmentSource;
+		ProgramCallback onProgram;
+
+		MeshDecoder decoder;
+		MeshData mesh;
+		MeshCallback onMesh;
+
+		// Filled by the upload thread
+		GLuint program = 0;
+		GLuint vertexBuffer = 0;
+		GLuint indexBuffer = 0;
+		GLsync fence = nullptr;
+	};
+
+	static bool readFile(const std::string& t_path, std::string& t_dest);
+	static GLuint compileShader(GLenum t_type, const std::string& t_source, const std::string& t_path);
+
+	void enqueue(std::unique_ptr<Request> t_request);
+	bool deliver(GLResources& t_resources, bool t_wait);
+	void decodeLoop();
+	void uploadLoop();
+	void upload(Request& t_request);
+
+	unsigned m_workerCount;
+	std::vector<std::thread> m_workers;
+	std::thread m_uploader;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_decodeReady, m_uploadReady, m_uploaded;
+	std::deque<std::unique_ptr<Request>> m_decodeQueue;
+	std::deque<std::unique_ptr<Request>> m_uploadQueue;
+	std::vector<std::unique_ptr<Request>> m_fenced; // uploaded, in any order
+	unsigned m_nextId; // next request to hand over, so callbacks run in request order
+	unsigned m_issued;
+	bool m_running, m_stopping;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include <BufferAllocator.h>
+
+#include <algorithm>
+#include <iterator>
+
+BufferAllocator::BufferAllocator(uint32_t t_capacity)
+{
+	reset(t_capacity);
+}
+
+/////////////////////////////////////////////////////////
+
+void BufferAllocator::reset(uint32_t t_capacity)
+{
+	m_capacity = t_capacity;
+	m_used = 0;
+	m_free.clear();
+	m_allocated.clear();
+
+	if (t_capacity > 0)
+	{
+		m_free[0] = t_capacity;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Best fit: the smallest free range that still fits once aligned. Padding
+/// in front of the aligned offset and the unused tail go back to the free list.
+/// </summary>
+/// <param name="t_size">units to allocate, at least 1</param>
+/// <param name="t_alignment">power of two the offset must be a multiple of</param>
+/// <returns>offset of the range, or INVALID</returns>
+uint32_t BufferAllocator::allocate(uint32_t t_size, uint32_t t_alignment)
+{
+	if (t_size == 0 || t_alignment == 0 || (t_alignment & (t_alignment - 1)) != 0)
+	{
+		return INVALID;
+	}
+
+	std::map<uint32_t, uint32_t>::iterator best = m_free.end();
+	uint32_t bestWaste = INVALID;
+
+	for (std::map<uint32_t, uint32_t>::iterator it = m_free.begin(); it != m_free.end(); ++it)
+	{
+		const uint32_t aligned = (it->first + t_alignment - 1) & ~(t_alignment - 1);
+		const uint32_t padding = aligned - it->first;
+
+		if (padding > it->second || it->second - padding < t_size)
+		{
+			continue;
+		}
+
+		const uint32_t waste = it->second - t_size;
+		if (waste < bestWaste)
+		{
+			best = it;
+			bestWaste = waste;
+			if (waste == padding) break; // exact fit
+		}
+	}
+
+	if (best == m_free.end())
+	{
+		return INVALID;
+	}
+
+	const uint32_t start = best->first;
+	const uint32_t size = best->second;
+	const uint32_t offset = (start + t_alignment - 1) & ~(t_alignment - 1);
+	const uint32_t end = offset + t_size;
+	m_free.erase(best);
+
+	if (offset > start)
+	{
+		m_free[start] = offset - start;
+	}
+	if (end < start + size)
+	{
+		m_free[end] = start + size - end;
+	}
+
+	m_allocated[offset] = t_size;
+	m_used += t_size;
+
+	return offset;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Returns a range from allocate(). Unknown offsets are ignored.
+/// </summary>
+void BufferAllocator::free(uint32_t t_offset)
+{
+	std::map<uint32_t, uint32_t>::iterator it = m_allocated.find(t_offset);
+	if (it == m_allocated.end())
+	{
+		return;
+	}
+
+	const uint32_t size = it->second;
+	m_allocated.erase(it);
+	m_used -= size;
+
+	release(t_offset, size);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Adds a range to the free list, merging it with free neighbours on either side
+/// </summary>
+void BufferAllocator::release(uint32_t t_offset, uint32_t t_size)
+{
+	uint32_t offset = t_offset;
+	uint32_t size = t_size;
+
+	std::map<uint32_t, uint32_t>::iterator next = m_free.lower_bound(offset);
+
+	if (next != m_free.begin())
+	{
+		std::map<uint32_t, uint32_t>::iterator previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			m_free.erase(previous);
+		}
+	}
+
+	if (next != m_free.end() && next->first == t_offset + t_size)
+	{
+		size += next->second;
+		m_free.erase(next);
+	}
+
+	m_free[offset] = size;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <returns>size of the allocation at t_offset, or 0 if there is none</returns>
+uint32_t BufferAllocator::getSize(uint32_t t_offset) const
+{
+	std::map<uint32_t, uint32_t>::const_iterator it = m_allocated.find(t_offset);
+
+	return it == m_allocated.end() ? 0 : it->second;
+}
+
+/////////////////////////////////////////////////////////
+
+BufferAllocatorStats BufferAllocator::getStats() const
+{
+	BufferAllocatorStats stats;
+	stats.capacity = m_capacity;
+	stats.used = m_used;
+	stats.allocations = static_cast<unsigned>(m_allocated.size());
+	stats.freeBlocks = static_cast<unsigned>(m_free.size());
+
+	for (const std::pair<const uint32_t, uint32_t>& block : m_free)
+	{
+		stats.largestFree = std::max(stats.largestFree, block.second);
+	}
+
+	return stats;
+}
@@ -0,0 +1,52 @@
+#ifndef BUFFER_ALLOCATOR_H
+#define BUFFER_ALLOCATOR_H
+
+#include <cstdint>
+#include <map>
+
+/// <summary>
+/// Usage of a BufferAllocator, in its own units
+/// </summary>
+struct BufferAllocatorStats
+{
+	uint32_t capacity = 0;
+	uint32_t used = 0;
+	uint32_t largestFree = 0;
+	unsigned allocations = 0;
+	unsigned freeBlocks = 0;
+};
+
+/// <summary>
+/// Hands out ranges of a fixed-size address space, such as a GPU buffer, and
+/// never touches the memory itself. Free ranges are kept in offset order and
+/// merged with their neighbours when freed. allocate() takes the smallest
+/// free range that fits, which keeps large ranges intact for large requests.
+/// Units are up to the caller: bytes, vertices, indices.
+/// </summary>
+class BufferAllocator
+{
+public:
+	static const uint32_t INVALID = 0xFFFFFFFF;
+
+	explicit BufferAllocator(uint32_t t_capacity = 0);
+
+	void reset(uint32_t t_capacity); // forgets every allocation
+
+	// t_alignment must be a power of two; returns INVALID if nothing fits
+	uint32_t allocate(uint32_t t_size, uint32_t t_alignment = 1);
+	void free(uint32_t t_offset);
+
+	uint32_t getCapacity() const { return m_capacity; }
+	uint32_t getSize(uint32_t t_offset) const;
+	BufferAllocatorStats getStats() const;
+
+private:
+	void release(uint32_t t_offset, uint32_t t_size);
+
+	uint32_t m_capacity;
+	uint32_t m_used;
+	std::map<uint32_t, uint32_t> m_free; // offset -> size
+	std::map<uint32_t, uint32_t> m_allocated; // offset -> size
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include <CameraPath.h>
+#include <Debug.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/// <summary>
+/// Parses a camera script, replacing any path already loaded
+/// </summary>
+/// <param name="t_fileSrc">script file</param>
+/// <returns>false if the file is missing, malformed or has no keyframes</returns>
+bool CameraPath::load(const std::string& t_fileSrc)
+{
+	std::ifstream inputStream{ t_fileSrc };
+
+	if (!inputStream.is_open())
+	{
+		DEBUG_MSG("ERROR while opening camera script: " + t_fileSrc);
+		return false;
+	}
+
+	m_keys.clear();
+
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(inputStream, line))
+	{
+		lineNumber++;
+
+		std::istringstream fields{ line.substr(0, line.find('#')) };
+		std::string first;
+		if (!(fields >> first)) continue; // blank or comment
+
+		bool valid;
+		if (first == "fps")
+		{
+			valid = (fields >> m_fps) && m_fps > 0.0f;
+		}
+		else if (first == "size")
+		{
+			valid = (fields >> m_width >> m_height) && m_width > 0 && m_height > 0;
+		}
+		else
+		{
+			CameraPose key;
+			std::istringstream time{ first };
+			valid = (time >> key.time) && (fields >> key.x >> key.y >> key.z >> key.yaw >> key.pitch)
+				&& (m_keys.empty() || key.time > m_keys.back().time);
+			if (valid) m_keys.push_back(key);
+		}
+
+		if (!valid)
+		{
+			DEBUG_MSG("ERROR in camera script " + t_fileSrc + " at line " + std::to_string(lineNumber));
+			m_keys.clear();
+			return false;
+		}
+	}
+
+	return !m_keys.empty();
+}
+
+/////////////////////////////////////////////////////////
+
+unsigned CameraPath::getFrameCount() const
+{
+	if (m_keys.empty()) return 0;
+
+	return static_cast<unsigned>((m_keys.back().time - m_keys.front().time) * m_fps) + 1;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Interpolates the pose at frame t_frame / fps seconds after the first keyframe
+/// </summary>
+CameraPose CameraPath::sample(unsigned t_frame) const
+{
+	const float time = m_keys.front().time + t_frame / m_fps;
+
+	// First keyframe after time; the pose lies between it and the one before
+	std::vector<CameraPose>::const_iterator next = std::upper_bound(m_keys.begin(), m_keys.end(), time,
+		[](float t_time, const CameraPose& t_key) { return t_time < t_key.time; });
+
+	if (next == m_keys.begin()) return m_keys.front();
+	if (next == m_keys.end()) return m_keys.back();
+
+	const CameraPose& a = *(next - 1);
+	const CameraPose& b = *next;
+	const float t = (time - a.time) / (b.time - a.time);
+
+	CameraPose pose;
+	pose.time = time;
+	pose.x = a.x + (b.x - a.x) * t;
+	pose.y = a.y + (b.y - a.y) * t;
+	pose.z = a.z + (b.z - a.z) * t;
+	pose.yaw = a.yaw + (b.yaw - a.yaw) * t;
+	pose.pitch = a.pitch + (b.pitch - a.pitch) * t;
+
+	return pose;
+}
@@ -0,0 +1,47 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Camera and animation state for one frame
+/// </summary>
+struct CameraPose
+{
+	float time = 0.0f; // animation time in seconds
+	float x = 0.0f, y = 0.0f, z = 0.0f; // translation
+	float yaw = 0.0f, pitch = 0.0f; // degrees
+};
+
+/// <summary>
+/// Keyframed camera path read from a text script and sampled at a fixed rate.
+///
+///   # comment
+///   fps 30             frames per second of animation time (default 30)
+///   size 1280 720      offscreen target size (default 800 600)
+///   0  0 0 -8  0   0   keyframe: time x y z yaw pitch
+///   4  0 0 -4  360 30
+///
+/// Keyframes must be in increasing time order; poses are linearly interpolated.
+/// </summary>
+class CameraPath
+{
+public:
+	bool load(const std::string& t_fileSrc);
+
+	unsigned getFrameCount() const;
+	CameraPose sample(unsigned t_frame) const;
+
+	float getFrameRate() const { return m_fps; }
+	unsigned getWidth() const { return m_width; }
+	unsigned getHeight() const { return m_height; }
+
+private:
+	std::vector<CameraPose> m_keys;
+	float m_fps = 30.0f;
+	unsigned m_width = 800;
+	unsigned m_height = 600;
+};
+
+#endif
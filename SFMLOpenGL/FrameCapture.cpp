@@ -0,0 +1,359 @@
+#include <FrameCapture.h>
+#include <Debug.h>
+#include <Trace.h>
+
+#include <SFML/Graphics.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+FrameCapture::FrameCapture() :
+	m_capturing{ false },
+	m_width{ 0 },
+	m_height{ 0 },
+	m_format{ PNG },
+	m_lossless{ false },
+	m_oldest{ 0 },
+	m_inFlight{ 0 },
+	m_frame{ 0 },
+	m_queued{ 0 },
+	m_dropped{ 0 },
+	m_numFree{ 0 },
+	m_firstJob{ 0 },
+	m_numJobs{ 0 },
+	m_stopping{ false },
+	m_stream{ nullptr },
+	m_written{ 0 }
+{
+}
+
+/////////////////////////////////////////////////////////
+
+FrameCapture::~FrameCapture()
+{
+	// The PBOs need a context and are left to stop(); the worker must not outlive us
+	if (m_worker.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_ready.notify_one();
+		m_worker.join();
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Allocates the frame pool and starts the encoder thread. The PBO ring is
+/// created by the first capture(), so CPU-only use through submit() needs no
+/// GL. Nothing is allocated per frame after that.
+/// </summary>
+/// <param name="t_width">width of the region read from the back buffer</param>
+/// <param name="t_height">height of the region read from the back buffer</param>
+/// <param name="t_directory">created if missing</param>
+/// <param name="t_format">PNG files or a raw RGBA stream</param>
+/// <returns>false if already capturing or the output could not be created</returns>
+bool FrameCapture::start(unsigned t_width, unsigned t_height, const std::string& t_directory, Format t_format)
+{
+	if (m_capturing) return false;
+
+	std::error_code error;
+	std::filesystem::create_directories(t_directory, error);
+
+	if (t_format == RAW)
+	{
+		m_stream = std::fopen((t_directory + "/capture.rgba").c_str(), "wb");
+		if (!m_stream)
+		{
+			DEBUG_MSG("ERROR: Could not create capture stream in " + t_directory);
+			return false;
+		}
+	}
+
+	m_width = t_width;
+	m_height = t_height;
+	m_directory = t_directory;
+	m_format = t_format;
+
+	const size_t size = static_cast<size_t>(m_width) * m_height * 4;
+
+	for (int i = 0; i < QUEUE_CAPACITY; i++)
+	{
+		m_buffers[i].resize(size);
+		m_free[i] = i;
+	}
+
+	m_numFree = QUEUE_CAPACITY;
+	m_firstJob = m_numJobs = 0;
+	m_stopping = false;
+	m_oldest = m_inFlight = 0;
+	m_frame = m_queued = m_dropped = 0;
+	m_written = 0;
+
+	m_worker = std::thread(&FrameCapture::encodeLoop, this);
+	m_capturing = true;
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Queues a readback of the current back buffer; call after drawing and
+/// before display(). Finished readbacks from earlier frames are collected first.
+/// </summary>
+void FrameCapture::capture(GLStateCache& t_glState)
+{
+	if (!m_capturing) return;
+
+	if (m_ring[0].pbo == 0)
+	{
+		const GLsizeiptr size = static_cast<GLsizeiptr>(m_width) * m_height * 4;
+
+		for (int i = 0; i < RING_SIZE; i++)
+		{
+			glGenBuffers(1, &m_ring[i].pbo);
+			t_glState.bindBuffer(GL_PIXEL_PACK_BUFFER, m_ring[i].pbo);
+			glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		}
+		t_glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	collect(t_glState, false);
+
+	unsigned frame = m_frame++;
+
+	// Lossless capture waits for the oldest readback instead of dropping this frame
+	if (m_lossless && m_inFlight == RING_SIZE)
+	{
+		collectOldest(t_glState, true);
+	}
+
+	// Every PBO is still being filled; reusing one would block in the driver
+	if (m_inFlight == RING_SIZE)
+	{
+		m_dropped++;
+		return;
+	}
+
+	Slot& slot = m_ring[(m_oldest + m_inFlight) % RING_SIZE];
+	slot.frame = frame;
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	t_glState.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	t_glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_inFlight++;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Moves finished readbacks, oldest first, into the encoder queue
+/// </summary>
+/// <param name="t_wait">block on outstanding fences, used when stopping</param>
+void FrameCapture::collect(GLStateCache& t_glState, bool t_wait)
+{
+	while (m_inFlight > 0 && collectOldest(t_glState, t_wait))
+	{
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Retires the oldest readback in flight if its fence has signalled
+/// </summary>
+/// <param name="t_wait">block on the fence instead of returning</param>
+/// <returns>false if the readback is still pending</returns>
+bool FrameCapture::collectOldest(GLStateCache& t_glState, bool t_wait)
+{
+	Slot& slot = m_ring[m_oldest];
+
+	GLenum status = glClientWaitSync(slot.fence, t_wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+		t_wait ? 1000000000 : 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		if (!t_wait) return false;
+		m_dropped++; // timed out or failed; give up on this one
+	}
+	else
+	{
+		t_glState.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(m_width) * m_height * 4, GL_MAP_READ_BIT);
+
+		// Mapping failed, or the encoder is behind
+		if (!pixels || !enqueue(pixels, slot.frame))
+		{
+			m_dropped++;
+		}
+
+		if (pixels) glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		t_glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+	m_oldest = (m_oldest + 1) % RING_SIZE;
+	m_inFlight--;
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Queues a frame already in CPU memory, such as SoftwareRasterizer output:
+/// bottom-up RGBA8 rows of the size given to start()
+/// </summary>
+void FrameCapture::submit(const void* t_pixels)
+{
+	if (!m_capturing) return;
+
+	if (!enqueue(t_pixels, m_frame++))
+	{
+		m_dropped++;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Copies a frame into a free pool buffer and hands it to the worker
+/// </summary>
+/// <returns>false if the pool is exhausted and capture is not lossless</returns>
+bool FrameCapture::enqueue(const void* t_pixels, unsigned t_frame)
+{
+	int buffer = -1;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_lossless) m_freed.wait(lock, [this] { return m_numFree > 0; });
+		if (m_numFree > 0) buffer = m_free[--m_numFree];
+	}
+
+	if (buffer < 0) return false;
+
+	// Only this thread touches a buffer between taking it from the pool and queueing it
+	std::memcpy(m_buffers[buffer].data(), t_pixels, m_buffers[buffer].size());
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs[(m_firstJob + m_numJobs) % QUEUE_CAPACITY] = Job{ buffer, t_frame };
+		m_numJobs++;
+	}
+	m_ready.notify_one();
+	m_queued++;
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Flushes readbacks still in flight, waits for the encoder to drain its
+/// queue and releases the PBOs. Needs the capturing context to be current.
+/// </summary>
+void FrameCapture::stop(GLStateCache& t_glState)
+{
+	if (!m_capturing) return;
+
+	collect(t_glState, true);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_ready.notify_one();
+	m_worker.join();
+
+	for (int i = 0; i < RING_SIZE && m_ring[i].pbo != 0; i++)
+	{
+		t_glState.forgetBuffer(m_ring[i].pbo);
+		glDeleteBuffers(1, &m_ring[i].pbo);
+		m_ring[i].pbo = 0;
+	}
+
+	if (m_stream)
+	{
+		std::fclose(m_stream);
+		m_stream = nullptr;
+	}
+
+	m_capturing = false;
+
+	DEBUG_MSG("Capture stopped: " + std::to_string(m_written) + " frames written, "
+		+ std::to_string(m_dropped) + " dropped");
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Worker thread: encodes queued frames until stopped and the queue is empty
+/// </summary>
+void FrameCapture::encodeLoop()
+{
+	TRACE_THREAD_NAME("capture encode");
+
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_ready.wait(lock, [this] { return m_numJobs > 0 || m_stopping; });
+
+			if (m_numJobs == 0) return;
+
+			job = m_jobs[m_firstJob];
+			m_firstJob = (m_firstJob + 1) % QUEUE_CAPACITY;
+			m_numJobs--;
+		}
+
+		encode(m_buffers[job.buffer], job.frame);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_free[m_numFree++] = job.buffer;
+		}
+		m_freed.notify_one();
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Writes one frame. GL rows are bottom-up, so they are flipped on the way out.
+/// </summary>
+void FrameCapture::encode(std::vector<unsigned char>& t_pixels, unsigned t_frame)
+{
+	TRACE_SCOPE("FrameCapture::encode", "job");
+
+	const size_t row = static_cast<size_t>(m_width) * 4;
+
+	if (m_format == RAW)
+	{
+		bool written = true;
+		for (unsigned y = m_height; y-- > 0; )
+		{
+			written = std::fwrite(t_pixels.data() + y * row, 1, row, m_stream) == row && written;
+		}
+		if (written) m_written++;
+		return;
+	}
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "/frame_%06u.png", t_frame);
+
+	sf::Image image;
+	image.create(m_width, m_height, t_pixels.data());
+	image.flipVertically();
+
+	if (image.saveToFile(m_directory + name))
+	{
+		m_written++;
+	}
+}
@@ -0,0 +1,105 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <GLStateCache.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Records the back buffer without stalling the render loop. Each capture()
+/// starts an asynchronous glReadPixels into one of a ring of pixel buffer
+/// objects; a buffer is only mapped once its fence has signalled, frames
+/// later, and the pixels are copied into a fixed pool and handed to a worker
+/// thread that encodes them. When the ring or the pool is full the frame is
+/// dropped and counted rather than waited for, unless capture is lossless.
+/// Frames rendered on the CPU can be fed to the same encoder with submit().
+/// </summary>
+class FrameCapture
+{
+public:
+	enum Format
+	{
+		PNG, // one numbered file per frame
+		RAW // top-down RGBA8 frames appended to a single capture.rgba stream
+	};
+
+	static const int RING_SIZE = 3; // readbacks in flight on the GPU
+	static const int QUEUE_CAPACITY = 8; // frames waiting for or being encoded
+
+	FrameCapture();
+	~FrameCapture();
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	bool start(unsigned t_width, unsigned t_height, const std::string& t_directory, Format t_format);
+	void capture(GLStateCache& t_glState);
+	void submit(const void* t_pixels);
+	void stop(GLStateCache& t_glState);
+
+	// Wait for the GPU and the encoder instead of dropping frames, for offline rendering
+	void setLossless(bool t_lossless) { m_lossless = t_lossless; }
+
+	bool isCapturing() const { return m_capturing; }
+	unsigned getQueued() const { return m_queued; }
+	unsigned getDropped() const { return m_dropped; }
+	unsigned getWritten() const { return m_written; }
+
+private:
+	struct Slot
+	{
+		GLuint pbo = 0;
+		GLsync fence = nullptr;
+		unsigned frame = 0;
+	};
+
+	struct Job
+	{
+		int buffer;
+		unsigned frame;
+	};
+
+	void collect(GLStateCache& t_glState, bool t_wait);
+	bool collectOldest(GLStateCache& t_glState, bool t_wait);
+	bool enqueue(const void* t_pixels, unsigned t_frame);
+	void encodeLoop();
+	void encode(std::vector<unsigned char>& t_pixels, unsigned t_frame);
+
+	bool m_capturing;
+	unsigned m_width, m_height;
+	std::string m_directory;
+	Format m_format;
+	bool m_lossless;
+
+	// Render thread only
+	Slot m_ring[RING_SIZE];
+	int m_oldest; // first slot in flight
+	int m_inFlight;
+	unsigned m_frame;
+	unsigned m_queued;
+	unsigned m_dropped;
+
+	// Shared with the worker, guarded by m_mutex
+	std::mutex m_mutex;
+	std::condition_variable m_ready; // a job was queued
+	std::condition_variable m_freed; // a buffer was returned to the pool
+	std::vector<unsigned char> m_buffers[QUEUE_CAPACITY];
+	int m_free[QUEUE_CAPACITY];
+	int m_numFree;
+	Job m_jobs[QUEUE_CAPACITY];
+	int m_firstJob;
+	int m_numJobs;
+	bool m_stopping;
+
+	// Worker only
+	std::thread m_worker;
+	FILE* m_stream;
+	std::atomic<unsigned> m_written;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include <FramePacer.h>
+#include <Trace.h>
+
+namespace
+{
+	const sf::Time MIN_SPIN_MARGIN{ sf::microseconds(1000) };
+	const sf::Time MAX_SPIN_MARGIN{ sf::microseconds(4000) };
+
+	// Fraction of the way the margin moves back towards a smaller overshoot per sleep
+	const float SPIN_MARGIN_DECAY = 0.1f;
+	const sf::Time LATENCY_SAFETY{ sf::microseconds(1000) }; // slack added to the work estimate
+}
+
+FramePacer::FramePacer() :
+	m_period{ sf::Time::Zero },
+	m_deadline{ sf::Time::Zero },
+	m_workStart{ sf::Time::Zero },
+	m_workEstimate{ sf::Time::Zero },
+	m_spinMargin{ MIN_SPIN_MARGIN },
+	m_mode{ THROUGHPUT }
+{
+}
+
+/////////////////////////////////////////////////////////
+
+void FramePacer::setTargetRate(float t_framesPerSecond)
+{
+	m_period = (t_framesPerSecond > 0.0f) ? sf::seconds(1.0f / t_framesPerSecond) : sf::Time::Zero;
+	m_deadline = m_clock.getElapsedTime() + m_period;
+}
+
+/////////////////////////////////////////////////////////
+
+void FramePacer::setMode(Mode t_mode)
+{
+	m_mode = t_mode;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Call before sampling input. In LOW_LATENCY mode this waits until there is
+/// just enough time left to do the frame's work before the deadline.
+/// </summary>
+void FramePacer::beginFrame()
+{
+	if (m_mode == LOW_LATENCY && m_period > sf::Time::Zero)
+	{
+		waitUntil(m_deadline - m_workEstimate - LATENCY_SAFETY);
+	}
+
+	m_workStart = m_clock.getElapsedTime();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Call after presenting. Updates the work estimate and, in THROUGHPUT mode,
+/// waits for the deadline before advancing it by one period.
+/// </summary>
+void FramePacer::endFrame()
+{
+	sf::Time now = m_clock.getElapsedTime();
+	sf::Time work = now - m_workStart;
+
+	// Rise immediately on a slow frame, decay slowly on fast ones
+	m_workEstimate = (work > m_workEstimate) ? work : m_workEstimate * 0.9f + work * 0.1f;
+
+	if (m_period == sf::Time::Zero)
+	{
+		return;
+	}
+
+	if (m_mode == THROUGHPUT)
+	{
+		waitUntil(m_deadline);
+		now = m_clock.getElapsedTime();
+	}
+
+	m_deadline += m_period;
+
+	// Missed by more than a whole frame: resync instead of bursting to catch up
+	if (m_deadline < now)
+	{
+		m_deadline = now + m_period;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Sleeps while the deadline is further away than the spin margin, then spins.
+/// The margin jumps up to any larger oversleep so coarse OS timers are absorbed,
+/// and eases back down as a moving average once sleeps finish on time again.
+/// </summary>
+void FramePacer::waitUntil(sf::Time t_deadline)
+{
+	TRACE_SCOPE("FramePacer::waitUntil", "frame");
+
+	sf::Time remaining = t_deadline - m_clock.getElapsedTime();
+
+	while (remaining > m_spinMargin)
+	{
+		sf::Time request = remaining - m_spinMargin;
+		sf::Time before = m_clock.getElapsedTime();
+		sf::sleep(request);
+		sf::Time overshoot = (m_clock.getElapsedTime() - before) - request;
+
+		if (overshoot > m_spinMargin)
+		{
+			m_spinMargin = (overshoot < MAX_SPIN_MARGIN) ? overshoot : MAX_SPIN_MARGIN;
+		}
+		else
+		{
+			// One descheduled sleep should not make every later frame spin
+			const sf::Time target = (overshoot > MIN_SPIN_MARGIN) ? overshoot : MIN_SPIN_MARGIN;
+			m_spinMargin -= (m_spinMargin - target) * SPIN_MARGIN_DECAY;
+		}
+
+		remaining = t_deadline - m_clock.getElapsedTime();
+	}
+
+	while (m_clock.getElapsedTime() < t_deadline)
+	{
+		// spin
+	}
+}
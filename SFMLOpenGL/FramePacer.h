@@ -0,0 +1,46 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <SFML/System.hpp>
+
+/// <summary>
+/// Caps the frame rate with a hybrid wait: the OS sleeps for most of the
+/// remaining time, then a short spin hits the deadline precisely.
+///
+/// THROUGHPUT mode does the frame's work first and waits afterwards.
+/// LOW_LATENCY mode waits first, so input sampling and update() happen as
+/// late as possible and the frame is presented just as its deadline arrives.
+/// </summary>
+class FramePacer
+{
+public:
+	enum Mode
+	{
+		THROUGHPUT,
+		LOW_LATENCY
+	};
+
+	FramePacer();
+
+	void setTargetRate(float t_framesPerSecond); // 0 disables the cap
+	void setMode(Mode t_mode);
+	Mode getMode() const { return m_mode; }
+
+	void beginFrame();
+	void endFrame();
+
+	sf::Time getWorkEstimate() const { return m_workEstimate; }
+
+private:
+	void waitUntil(sf::Time t_deadline);
+
+	sf::Clock m_clock;
+	sf::Time m_period;
+	sf::Time m_deadline;
+	sf::Time m_workStart;
+	sf::Time m_workEstimate; // smoothed time from beginFrame() to endFrame()
+	sf::Time m_spinMargin; // how far ahead of a deadline to stop sleeping and spin
+	Mode m_mode;
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include <FrameProfiler.h>
+#include <Trace.h>
+
+#include <cstdio>
+
+/// <summary>
+/// Registers a pass. GPU passes allocate their query objects, so a GL context must be current.
+/// </summary>
+/// <param name="t_name">name shown by toString()</param>
+/// <param name="t_gpu">true to also time the pass on the GPU</param>
+/// <returns>pass ID, or -1 if MAX_PASSES is exceeded</returns>
+int FrameProfiler::addPass(const std::string& t_name, bool t_gpu)
+{
+	if (m_numPasses >= MAX_PASSES)
+	{
+		return -1;
+	}
+
+	Pass& pass = m_passes[m_numPasses];
+	pass.name = t_name;
+#if (TRACE_ENABLED >= 1)
+	pass.traceName = Trace::intern(t_name);
+#endif
+	pass.gpu = t_gpu;
+
+	if (t_gpu)
+	{
+		glGenQueries(LATENCY * 2, &pass.queries[0][0]);
+	}
+
+	return m_numPasses++;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Reads back the slot about to be reused, if its results have arrived
+/// </summary>
+void FrameProfiler::beginFrame()
+{
+	int slot = m_frame % LATENCY;
+
+	for (int i = 0; i < m_numPasses; i++)
+	{
+		resolve(m_passes[i], slot);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void FrameProfiler::endFrame()
+{
+	m_frame++;
+}
+
+/////////////////////////////////////////////////////////
+
+void FrameProfiler::beginPass(int t_pass)
+{
+	Pass& pass = m_passes[t_pass];
+	int slot = m_frame % LATENCY;
+
+	if (pass.gpu)
+	{
+		glQueryCounter(pass.queries[slot][0], GL_TIMESTAMP);
+	}
+
+	pass.cpuStart = Clock::now();
+#if (TRACE_ENABLED >= 1)
+	pass.traceStart = Trace::now();
+#endif
+}
+
+/////////////////////////////////////////////////////////
+
+void FrameProfiler::endPass(int t_pass)
+{
+	Pass& pass = m_passes[t_pass];
+	int slot = m_frame % LATENCY;
+
+	pass.cpuMs[slot] = std::chrono::duration<double, std::milli>(Clock::now() - pass.cpuStart).count();
+#if (TRACE_ENABLED >= 1)
+	Trace::record(pass.traceName, "frame", pass.traceStart, Trace::now());
+#endif
+
+	if (pass.gpu)
+	{
+		glQueryCounter(pass.queries[slot][1], GL_TIMESTAMP);
+	}
+
+	pass.pending[slot] = true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Copies a slot's CPU time and GPU timestamps into the resolved timing.
+/// If the GPU result is still not available the previous GPU value is kept
+/// rather than blocking.
+/// </summary>
+void FrameProfiler::resolve(Pass& t_pass, int t_slot)
+{
+	if (!t_pass.pending[t_slot])
+	{
+		return;
+	}
+
+	t_pass.pending[t_slot] = false;
+	t_pass.resolved.cpuMs = t_pass.cpuMs[t_slot];
+
+	if (t_pass.gpu)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(t_pass.queries[t_slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (available)
+		{
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(t_pass.queries[t_slot][0], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(t_pass.queries[t_slot][1], GL_QUERY_RESULT, &end);
+			t_pass.resolved.gpuMs = (end - begin) / 1000000.0;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Formats every pass as "name cpu/gpu ms", e.g. for the window title
+/// </summary>
+std::string FrameProfiler::toString() const
+{
+	std::string output;
+	char buffer[64];
+
+	for (int i = 0; i < m_numPasses; i++)
+	{
+		const Pass& pass = m_passes[i];
+
+		if (pass.gpu)
+		{
+			snprintf(buffer, sizeof(buffer), "%s %.2f/%.2fms", pass.name.c_str(), pass.resolved.cpuMs, pass.resolved.gpuMs);
+		}
+		else
+		{
+			snprintf(buffer, sizeof(buffer), "%s %.2fms", pass.name.c_str(), pass.resolved.cpuMs);
+		}
+
+		if (i > 0) output += " | ";
+		output += buffer;
+	}
+
+	return output;
+}
+
+/////////////////////////////////////////////////////////
+
+void FrameProfiler::unload()
+{
+	for (int i = 0; i < m_numPasses; i++)
+	{
+		if (m_passes[i].gpu)
+		{
+			glDeleteQueries(LATENCY * 2, &m_passes[i].queries[0][0]);
+		}
+	}
+
+	m_numPasses = 0;
+}
@@ -0,0 +1,71 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Resolved timing of one pass, in milliseconds
+/// </summary>
+struct PassTiming
+{
+	double cpuMs = 0.0;
+	double gpuMs = 0.0;
+};
+
+/// <summary>
+/// Times named frame passes on the CPU and, optionally, on the GPU with
+/// glQueryCounter timestamp pairs. Queries are kept in a ring of LATENCY
+/// frames and only read once available, so the render loop never stalls
+/// waiting on the GPU; results are therefore LATENCY frames old.
+/// Every pass is also recorded as a Trace event.
+/// </summary>
+class FrameProfiler
+{
+public:
+	static const int MAX_PASSES = 8;
+	static const int LATENCY = 4; // frames between issuing a query and reading it back
+
+	int addPass(const std::string& t_name, bool t_gpu);
+
+	void beginFrame();
+	void endFrame();
+	void beginPass(int t_pass);
+	void endPass(int t_pass);
+
+	int getPassCount() const { return m_numPasses; }
+	const std::string& getPassName(int t_pass) const { return m_passes[t_pass].name; }
+	const PassTiming& getTiming(int t_pass) const { return m_passes[t_pass].resolved; }
+	unsigned getFrame() const { return m_frame; }
+
+	std::string toString() const;
+
+	void unload();
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Pass
+	{
+		std::string name;
+		bool gpu = false;
+		GLuint queries[LATENCY][2] = {}; // begin / end timestamp per slot
+		bool pending[LATENCY] = {};
+		double cpuMs[LATENCY] = {};
+		Clock::time_point cpuStart;
+		const char* traceName = ""; // interned copy of name
+		int64_t traceStart = 0;
+		PassTiming resolved;
+	};
+
+	void resolve(Pass& t_pass, int t_slot);
+
+	Pass m_passes[MAX_PASSES];
+	int m_numPasses = 0;
+	unsigned m_frame = 0;
+};
+
+#endif
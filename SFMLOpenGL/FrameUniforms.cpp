@@ -0,0 +1,148 @@
+#include <FrameUniforms.h>
+#include <Debug.h>
+#include <Trace.h>
+
+#include <iostream>
+#include <math.h>
+
+/// <summary>
+/// Creates the uniform buffer and binds it to BINDING_POINT. Requires a current GL context.
+/// </summary>
+void FrameUniforms::initialize(GLStateCache& t_state)
+{
+	glGenBuffers(1, &m_ubo);
+	t_state.bindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), NULL, GL_DYNAMIC_DRAW);
+
+	// Also sets the generic binding to m_ubo, which matches the shadow
+	glBindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, m_ubo);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Points a program's FrameData block at the shared binding point.
+/// Programs that do not declare the block are ignored.
+/// </summary>
+/// <param name="t_program">linked program ID</param>
+void FrameUniforms::attach(GLuint t_program) const
+{
+	GLuint blockIndex = glGetUniformBlockIndex(t_program, "FrameData");
+
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(t_program, blockIndex, BINDING_POINT);
+	}
+	else
+	{
+		DEBUG_MSG("Program has no FrameData uniform block");
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Uploads this frame's constants. Call once per frame before drawing.
+/// </summary>
+/// <param name="t_data">per-frame constants</param>
+void FrameUniforms::update(GLStateCache& t_state, const FrameData& t_data)
+{
+	TRACE_SCOPE("FrameUniforms::update", "gl");
+
+	t_state.bindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &t_data);
+}
+
+/////////////////////////////////////////////////////////
+
+void FrameUniforms::unload(GLStateCache& t_state)
+{
+	t_state.forgetBuffer(m_ubo);
+	glDeleteBuffers(1, &m_ubo);
+	m_ubo = 0;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Builds the same column-major projection matrix as gluPerspective
+/// </summary>
+void FrameUniforms::perspective(float t_fovyDegrees, float t_aspect, float t_near, float t_far, float t_out[16])
+{
+	const float f = 1.0f / tanf(t_fovyDegrees * 3.14159265f / 360.0f); // cot(fovy / 2)
+
+	for (int i = 0; i < 16; i++)
+	{
+		t_out[i] = 0.0f;
+	}
+
+	t_out[0] = f / t_aspect;
+	t_out[5] = f;
+	t_out[10] = (t_far + t_near) / (t_near - t_far);
+	t_out[11] = -1.0f;
+	t_out[14] = (2.0f * t_far * t_near) / (t_near - t_far);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Builds a column-major translation matrix, as glTranslatef would
+/// </summary>
+void FrameUniforms::translation(float t_x, float t_y, float t_z, float t_out[16])
+{
+	for (int i = 0; i < 16; i++)
+	{
+		t_out[i] = (i % 5 == 0) ? 1.0f : 0.0f; // identity
+	}
+
+	t_out[12] = t_x;
+	t_out[13] = t_y;
+	t_out[14] = t_z;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Column-major t_out = t_left * t_right, e.g. projection * view
+/// </summary>
+void FrameUniforms::multiply(const float t_left[16], const float t_right[16], float t_out[16])
+{
+	for (int col = 0; col < 4; col++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			float sum = 0.0f;
+			for (int k = 0; k < 4; k++)
+			{
+				sum += t_left[k * 4 + row] * t_right[col * 4 + k];
+			}
+			t_out[col * 4 + row] = sum;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Builds a column-major translate * rotateX(pitch) * rotateY(yaw) matrix,
+/// which turns the scene about its origin and then moves it into view
+/// </summary>
+void FrameUniforms::view(float t_yawDegrees, float t_pitchDegrees, float t_x, float t_y, float t_z, float t_out[16])
+{
+	const float yaw = t_yawDegrees * 3.14159265f / 180.0f;
+	const float pitch = t_pitchDegrees * 3.14159265f / 180.0f;
+	const float cy = cosf(yaw), sy = sinf(yaw);
+	const float cp = cosf(pitch), sp = sinf(pitch);
+
+	translation(t_x, t_y, t_z, t_out);
+
+	t_out[0] = cy;
+	t_out[1] = sp * sy;
+	t_out[2] = -cp * sy;
+	t_out[4] = 0.0f;
+	t_out[5] = cp;
+	t_out[6] = sp;
+	t_out[8] = sy;
+	t_out[9] = -sp * cy;
+	t_out[10] = cp * cy;
+}
@@ -0,0 +1,44 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <GL/glew.h>
+#include <GLStateCache.h>
+
+/// <summary>
+/// CPU mirror of the std140 "FrameData" uniform block declared in the shaders.
+/// Member order and padding must match the GLSL declaration exactly.
+/// </summary>
+struct FrameData
+{
+	float view[16]; // column-major, std140 offset 0
+	float projection[16]; // column-major, std140 offset 64
+	float time; // seconds since start, std140 offset 128
+	float deltaTime; // seconds since last frame, std140 offset 132
+	GLuint frameIndex; // std140 offset 136
+	float padding; // round block up to a multiple of 16 bytes
+};
+
+/// <summary>
+/// Owns the uniform buffer holding per-frame constants. The buffer is written
+/// once per frame and bound to a fixed binding point shared by every program.
+/// </summary>
+class FrameUniforms
+{
+public:
+	static const GLuint BINDING_POINT = 0;
+
+	void initialize(GLStateCache& t_state);
+	void attach(GLuint t_program) const;
+	void update(GLStateCache& t_state, const FrameData& t_data);
+	void unload(GLStateCache& t_state);
+
+	static void perspective(float t_fovyDegrees, float t_aspect, float t_near, float t_far, float t_out[16]);
+	static void translation(float t_x, float t_y, float t_z, float t_out[16]);
+	static void multiply(const float t_left[16], const float t_right[16], float t_out[16]);
+	static void view(float t_yawDegrees, float t_pitchDegrees, float t_x, float t_y, float t_z, float t_out[16]);
+
+private:
+	GLuint m_ubo = 0;
+};
+
+#endif
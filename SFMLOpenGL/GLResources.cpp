@@ -0,0 +1,363 @@
+#include <GLResources.h>
+#include <Debug.h>
+#include <Trace.h>
+
+#include <iostream>
+
+namespace
+{
+	const char* TYPE_NAMES[RESOURCE_TYPE_COUNT] = { "buffers", "vertex arrays", "shaders", "programs" };
+}
+
+GLResources::GLResources(GLStateCache& t_state) :
+	m_state{ t_state },
+	m_shutdown{ false }
+{
+}
+
+/////////////////////////////////////////////////////////
+
+GLResources::~GLResources()
+{
+	shutdown();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Generates names in one call so later creates do not hit the driver
+/// </summary>
+void GLResources::reserve(GLResourceType t_type, int t_count)
+{
+	if (t_count <= 0 || m_shutdown || (t_type != BUFFER_RESOURCE && t_type != VERTEX_ARRAY_RESOURCE))
+	{
+		return;
+	}
+
+	std::vector<GLuint>& pool = m_pool[t_type];
+	const size_t first = pool.size();
+	pool.resize(first + t_count);
+
+	if (t_type == BUFFER_RESOURCE)
+	{
+		glGenBuffers(t_count, &pool[first]);
+	}
+	else
+	{
+		glGenVertexArrays(t_count, &pool[first]);
+	}
+
+	m_stats.pooledNames += t_count;
+}
+
+/////////////////////////////////////////////////////////
+
+GLBuffer GLResources::createBuffer()
+{
+	if (m_pool[BUFFER_RESOURCE].empty()) reserve(BUFFER_RESOURCE, NAME_BATCH);
+
+	GLuint name = m_pool[BUFFER_RESOURCE].back();
+	m_pool[BUFFER_RESOURCE].pop_back();
+	m_stats.pooledNames--;
+
+	GLHandle<BUFFER_RESOURCE> handle;
+	handle.index = allocate(BUFFER_RESOURCE, name);
+	handle.generation = m_slots[BUFFER_RESOURCE][handle.index].generation;
+
+	return GLBuffer(*this, handle);
+}
+
+/////////////////////////////////////////////////////////
+
+GLVertexArray GLResources::createVertexArray()
+{
+	if (m_pool[VERTEX_ARRAY_RESOURCE].empty()) reserve(VERTEX_ARRAY_RESOURCE, NAME_BATCH);
+
+	GLuint name = m_pool[VERTEX_ARRAY_RESOURCE].back();
+	m_pool[VERTEX_ARRAY_RESOURCE].pop_back();
+	m_stats.pooledNames--;
+
+	GLHandle<VERTEX_ARRAY_RESOURCE> handle;
+	handle.index = allocate(VERTEX_ARRAY_RESOURCE, name);
+	handle.generation = m_slots[VERTEX_ARRAY_RESOURCE][handle.index].generation;
+
+	return GLVertexArray(*this, handle);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <param name="t_shaderType">GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, ...</param>
+GLShader GLResources::createShader(GLenum t_shaderType)
+{
+	GLHandle<SHADER_RESOURCE> handle;
+	handle.index = allocate(SHADER_RESOURCE, glCreateShader(t_shaderType));
+	handle.generation = m_slots[SHADER_RESOURCE][handle.index].generation;
+
+	return GLShader(*this, handle);
+}
+
+/////////////////////////////////////////////////////////
+
+GLProgram GLResources::createProgram()
+{
+	GLHandle<PROGRAM_RESOURCE> handle;
+	handle.index = allocate(PROGRAM_RESOURCE, glCreateProgram());
+	handle.generation = m_slots[PROGRAM_RESOURCE][handle.index].generation;
+
+	return GLProgram(*this, handle);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <param name="t_bytes">storage already allocated, counted towards liveBytes</param>
+GLBuffer GLResources::adoptBuffer(GLuint t_name, size_t t_bytes)
+{
+	GLHandle<BUFFER_RESOURCE> handle;
+	handle.index = allocate(BUFFER_RESOURCE, t_name);
+	handle.generation = m_slots[BUFFER_RESOURCE][handle.index].generation;
+
+	m_slots[BUFFER_RESOURCE][handle.index].bytes = t_bytes;
+	m_stats.liveBytes += t_bytes;
+
+	return GLBuffer(*this, handle);
+}
+
+/////////////////////////////////////////////////////////
+
+GLProgram GLResources::adoptProgram(GLuint t_name)
+{
+	GLHandle<PROGRAM_RESOURCE> handle;
+	handle.index = allocate(PROGRAM_RESOURCE, t_name);
+	handle.generation = m_slots[PROGRAM_RESOURCE][handle.index].generation;
+
+	return GLProgram(*this, handle);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// glBufferData through the state cache; the size counts towards liveBytes
+/// until the buffer is released or reallocated
+/// </summary>
+void GLResources::bufferData(GLHandle<BUFFER_RESOURCE> t_buffer, GLenum t_target, GLsizeiptr t_size, const void* t_data, GLenum t_usage)
+{
+	GLuint name = get(t_buffer);
+	if (name == 0) return;
+
+	m_state.bindBuffer(t_target, name);
+	glBufferData(t_target, t_size, t_data, t_usage);
+
+	Slot& slot = m_slots[BUFFER_RESOURCE][t_buffer.index];
+	m_stats.liveBytes -= slot.bytes;
+	slot.bytes = static_cast<size_t>(t_size);
+	m_stats.liveBytes += slot.bytes;
+}
+
+/////////////////////////////////////////////////////////
+
+uint32_t GLResources::allocate(GLResourceType t_type, GLuint t_name)
+{
+	uint32_t index;
+
+	if (!m_freeSlots[t_type].empty())
+	{
+		index = m_freeSlots[t_type].back();
+		m_freeSlots[t_type].pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_slots[t_type].size());
+		m_slots[t_type].push_back(Slot());
+	}
+
+	Slot& slot = m_slots[t_type][index];
+	slot.name = t_name;
+	slot.bytes = 0;
+	slot.live = true;
+	m_stats.live[t_type]++;
+
+	return index;
+}
+
+/////////////////////////////////////////////////////////
+
+GLuint GLResources::lookup(GLResourceType t_type, uint32_t t_index, uint32_t t_generation) const
+{
+	return isLive(t_type, t_index, t_generation) ? m_slots[t_type][t_index].name : 0;
+}
+
+/////////////////////////////////////////////////////////
+
+bool GLResources::isLive(GLResourceType t_type, uint32_t t_index, uint32_t t_generation) const
+{
+	return t_index < m_slots[t_type].size()
+		&& m_slots[t_type][t_index].live
+		&& m_slots[t_type][t_index].generation == t_generation;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Invalidates a handle and queues its object for deletion at the next fence.
+/// Stale or null handles are ignored.
+/// </summary>
+void GLResources::retire(GLResourceType t_type, uint32_t t_index, uint32_t t_generation)
+{
+	if (!isLive(t_type, t_index, t_generation))
+	{
+		return;
+	}
+
+	Slot& slot = m_slots[t_type][t_index];
+	m_released.push_back(Retired{ t_type, slot.name });
+
+	m_stats.live[t_type]--;
+	m_stats.liveBytes -= slot.bytes;
+	m_stats.pendingDeletes++;
+
+	slot.live = false;
+	slot.name = 0;
+	slot.bytes = 0;
+	if (++slot.generation == 0) slot.generation = 1;
+	m_freeSlots[t_type].push_back(t_index);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Fences everything released this frame and deletes earlier batches the GPU is done with
+/// </summary>
+void GLResources::endFrame()
+{
+	TRACE_SCOPE("GLResources::endFrame", "gl");
+
+	if (!m_released.empty())
+	{
+		RetiredBatch batch;
+		batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		batch.objects.swap(m_released);
+		m_retiring.push_back(std::move(batch));
+	}
+
+	collect(false);
+}
+
+/////////////////////////////////////////////////////////
+
+void GLResources::collect(bool t_wait)
+{
+	size_t done = 0;
+
+	for (; done < m_retiring.size(); done++)
+	{
+		RetiredBatch& batch = m_retiring[done];
+
+		GLenum status = glClientWaitSync(batch.fence, t_wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+			t_wait ? 1000000000 : 0);
+		if (!t_wait && status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+
+		for (const Retired& object : batch.objects)
+		{
+			destroy(object);
+		}
+
+		glDeleteSync(batch.fence);
+	}
+
+	m_retiring.erase(m_retiring.begin(), m_retiring.begin() + done);
+}
+
+/////////////////////////////////////////////////////////
+
+void GLResources::destroy(const Retired& t_object)
+{
+	switch (t_object.type)
+	{
+	case BUFFER_RESOURCE:
+		m_state.forgetBuffer(t_object.name);
+		glDeleteBuffers(1, &t_object.name);
+		break;
+	case VERTEX_ARRAY_RESOURCE:
+		m_state.forgetVertexArray(t_object.name);
+		glDeleteVertexArrays(1, &t_object.name);
+		break;
+	case SHADER_RESOURCE:
+		glDeleteShader(t_object.name);
+		break;
+	case PROGRAM_RESOURCE:
+		m_state.forgetProgram(t_object.name);
+		glDeleteProgram(t_object.name);
+		break;
+	default:
+		break;
+	}
+
+	m_stats.pendingDeletes--;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Deletes everything: pending objects once the GPU is idle, pooled names,
+/// and any objects still live, which are reported as leaks. Needs the
+/// context to be current; handles resolve to 0 afterwards.
+/// </summary>
+void GLResources::shutdown()
+{
+	if (m_shutdown) return;
+
+	for (int type = 0; type < RESOURCE_TYPE_COUNT; type++)
+	{
+		if (m_stats.live[type] > 0)
+		{
+			DEBUG_MSG("WARNING: " + std::to_string(m_stats.live[type]) + " " + TYPE_NAMES[type] + " still live at shutdown");
+		}
+
+		for (uint32_t i = 0; i < m_slots[type].size(); i++)
+		{
+			if (m_slots[type][i].live)
+			{
+				retire(static_cast<GLResourceType>(type), i, m_slots[type][i].generation);
+			}
+		}
+	}
+
+	endFrame();
+	collect(true);
+
+	if (!m_pool[BUFFER_RESOURCE].empty())
+	{
+		glDeleteBuffers(static_cast<GLsizei>(m_pool[BUFFER_RESOURCE].size()), m_pool[BUFFER_RESOURCE].data());
+	}
+	if (!m_pool[VERTEX_ARRAY_RESOURCE].empty())
+	{
+		glDeleteVertexArrays(static_cast<GLsizei>(m_pool[VERTEX_ARRAY_RESOURCE].size()), m_pool[VERTEX_ARRAY_RESOURCE].data());
+	}
+	m_pool[BUFFER_RESOURCE].clear();
+	m_pool[VERTEX_ARRAY_RESOURCE].clear();
+	m_stats.pooledNames = 0;
+
+	m_shutdown = true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// One-line summary of the stats, for logs
+/// </summary>
+std::string GLResources::toString() const
+{
+	std::string result;
+
+	for (int type = 0; type < RESOURCE_TYPE_COUNT; type++)
+	{
+		result += std::to_string(m_stats.live[type]) + " " + TYPE_NAMES[type] + ", ";
+	}
+
+	return result + std::to_string(m_stats.liveBytes) + " buffer bytes, "
+		+ std::to_string(m_stats.pendingDeletes) + " pending deletes, "
+		+ std::to_string(m_stats.pooledNames) + " pooled names";
+}
@@ -0,0 +1,187 @@
+#ifndef GL_RESOURCES_H
+#define GL_RESOURCES_H
+
+#include <GL/glew.h>
+#include <GLStateCache.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum GLResourceType
+{
+	BUFFER_RESOURCE,
+	VERTEX_ARRAY_RESOURCE,
+	SHADER_RESOURCE,
+	PROGRAM_RESOURCE,
+	RESOURCE_TYPE_COUNT
+};
+
+/// <summary>
+/// Generation-checked ID of a GL object owned by GLResources. A handle whose
+/// object has been released no longer resolves, even if GL reuses the name.
+/// Generation 0 is never issued, so a default handle is null.
+/// </summary>
+template<GLResourceType TYPE>
+struct GLHandle
+{
+	uint32_t index = 0;
+	uint32_t generation = 0;
+};
+
+/// <summary>
+/// Live objects and buffer memory, as tracked by GLResources
+/// </summary>
+struct GLResourceStats
+{
+	unsigned live[RESOURCE_TYPE_COUNT] = {};
+	size_t liveBytes = 0; // buffer storage allocated through bufferData()
+	unsigned pendingDeletes = 0; // released, waiting for the GPU to finish with them
+	unsigned pooledNames = 0; // generated ahead of time, not yet handed out
+};
+
+template<GLResourceType TYPE> class GLResource;
+
+typedef GLResource<BUFFER_RESOURCE> GLBuffer;
+typedef GLResource<VERTEX_ARRAY_RESOURCE> GLVertexArray;
+typedef GLResource<SHADER_RESOURCE> GLShader;
+typedef GLResource<PROGRAM_RESOURCE> GLProgram;
+
+/// <summary>
+/// Owns every GL object created through it. Buffer and vertex array names
+/// are generated in batches and handed out from a pool. Released objects are
+/// not deleted straight away: endFrame() fences them, and they are deleted
+/// once that fence shows the GPU has finished every command that used them.
+/// </summary>
+class GLResources
+{
+public:
+	static const int NAME_BATCH = 64; // names generated per glGen* call when a pool runs dry
+
+	explicit GLResources(GLStateCache& t_state);
+	~GLResources();
+	GLResources(const GLResources&) = delete;
+	GLResources& operator=(const GLResources&) = delete;
+
+	void reserve(GLResourceType t_type, int t_count); // buffers and vertex arrays only
+
+	GLBuffer createBuffer();
+	GLVertexArray createVertexArray();
+	GLShader createShader(GLenum t_shaderType);
+	GLProgram createProgram();
+
+	// Takes ownership of objects created elsewhere, such as on a shared context
+	GLBuffer adoptBuffer(GLuint t_name, size_t t_bytes);
+	GLProgram adoptProgram(GLuint t_name);
+
+	// Binds the buffer to t_target and allocates its storage, recording the size
+	void bufferData(GLHandle<BUFFER_RESOURCE> t_buffer, GLenum t_target, GLsizeiptr t_size, const void* t_data, GLenum t_usage);
+
+	template<GLResourceType TYPE>
+	GLuint get(GLHandle<TYPE> t_handle) const { return lookup(TYPE, t_handle.index, t_handle.generation); }
+
+	template<GLResourceType TYPE>
+	void release(GLHandle<TYPE>& t_handle)
+	{
+		retire(TYPE, t_handle.index, t_handle.generation);
+		t_handle = GLHandle<TYPE>();
+	}
+
+	void endFrame();
+	void shutdown();
+
+	const GLResourceStats& getStats() const { return m_stats; }
+	std::string toString() const;
+
+private:
+	struct Slot
+	{
+		GLuint name = 0;
+		uint32_t generation = 1;
+		size_t bytes = 0;
+		bool live = false;
+	};
+
+	struct Retired
+	{
+		GLResourceType type;
+		GLuint name;
+	};
+
+	struct RetiredBatch
+	{
+		GLsync fence;
+		std::vector<Retired> objects;
+	};
+
+	uint32_t allocate(GLResourceType t_type, GLuint t_name);
+	GLuint lookup(GLResourceType t_type, uint32_t t_index, uint32_t t_generation) const;
+	bool isLive(GLResourceType t_type, uint32_t t_index, uint32_t t_generation) const;
+	void retire(GLResourceType t_type, uint32_t t_index, uint32_t t_generation);
+	void destroy(const Retired& t_object);
+	void collect(bool t_wait);
+
+	GLStateCache& m_state;
+	std::vector<Slot> m_slots[RESOURCE_TYPE_COUNT];
+	std::vector<uint32_t> m_freeSlots[RESOURCE_TYPE_COUNT];
+	std::vector<GLuint> m_pool[RESOURCE_TYPE_COUNT];
+	std::vector<Retired> m_released; // since the last endFrame()
+	std::vector<RetiredBatch> m_retiring; // oldest first
+	bool m_shutdown;
+	GLResourceStats m_stats;
+};
+
+/// <summary>
+/// Unique owner of one object in GLResources; releasing it on destruction
+/// or reset() queues the object for deferred deletion. Move-only.
+/// </summary>
+template<GLResourceType TYPE>
+class GLResource
+{
+public:
+	GLResource() : m_owner{ nullptr } {}
+	GLResource(GLResources& t_owner, GLHandle<TYPE> t_handle) : m_owner{ &t_owner }, m_handle{ t_handle } {}
+	~GLResource() { reset(); }
+
+	GLResource(const GLResource&) = delete;
+	GLResource& operator=(const GLResource&) = delete;
+
+	GLResource(GLResource&& t_other) : m_owner{ t_other.m_owner }, m_handle{ t_other.m_handle }
+	{
+		t_other.m_owner = nullptr;
+		t_other.m_handle = GLHandle<TYPE>();
+	}
+
+	GLResource& operator=(GLResource&& t_other)
+	{
+		if (this != &t_other)
+		{
+			reset();
+			m_owner = t_other.m_owner;
+			m_handle = t_other.m_handle;
+			t_other.m_owner = nullptr;
+			t_other.m_handle = GLHandle<TYPE>();
+		}
+		return *this;
+	}
+
+	// 0 once released, or if the owner has shut down
+	GLuint name() const { return m_owner ? m_owner->get(m_handle) : 0; }
+	GLHandle<TYPE> handle() const { return m_handle; }
+
+	void reset()
+	{
+		if (m_owner)
+		{
+			m_owner->release(m_handle);
+			m_owner = nullptr;
+		}
+	}
+
+private:
+	GLResources* m_owner;
+	GLHandle<TYPE> m_handle;
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include <GLStateCache.h>
+
+GLStateCache::GLStateCache()
+{
+	invalidate();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Records whether a call is needed and updates the counters
+/// </summary>
+/// <param name="t_different">true if the requested state differs from the shadow</param>
+/// <returns>true if the call must be issued</returns>
+bool GLStateCache::changed(bool t_different)
+{
+	(t_different) ? m_stats.issued++ : m_stats.elided++;
+	return t_different;
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::useProgram(GLuint t_program)
+{
+	if (changed(m_program != t_program))
+	{
+		glUseProgram(t_program);
+		m_program = t_program;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::bindVertexArray(GLuint t_vao)
+{
+	if (changed(m_vao != t_vao))
+	{
+		glBindVertexArray(t_vao);
+		m_vao = t_vao;
+
+		// The element array binding belongs to the VAO, so it is no longer known
+		m_buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::bindBuffer(GLenum t_target, GLuint t_buffer)
+{
+	std::map<GLenum, GLuint>::iterator it = m_buffers.find(t_target);
+
+	if (changed(it == m_buffers.end() || it->second != t_buffer))
+	{
+		glBindBuffer(t_target, t_buffer);
+		m_buffers[t_target] = t_buffer;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::bindTexture(GLuint t_unit, GLenum t_target, GLuint t_texture)
+{
+	// Units past the cache still work, they just always reach GL
+	if (t_unit >= static_cast<GLuint>(MAX_TEXTURE_UNITS))
+	{
+		changed(true);
+		if (m_activeTexture != t_unit)
+		{
+			glActiveTexture(GL_TEXTURE0 + t_unit);
+			m_activeTexture = t_unit;
+		}
+
+		glBindTexture(t_target, t_texture);
+		return;
+	}
+
+	std::map<GLenum, GLuint>& unit = m_textures[t_unit];
+	std::map<GLenum, GLuint>::iterator it = unit.find(t_target);
+
+	if (changed(it == unit.end() || it->second != t_texture))
+	{
+		// Part of the same bind, so not counted separately
+		if (m_activeTexture != t_unit)
+		{
+			glActiveTexture(GL_TEXTURE0 + t_unit);
+			m_activeTexture = t_unit;
+		}
+
+		glBindTexture(t_target, t_texture);
+		unit[t_target] = t_texture;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::enable(GLenum t_capability)
+{
+	std::map<GLenum, bool>::iterator it = m_capabilities.find(t_capability);
+
+	if (changed(it == m_capabilities.end() || !it->second))
+	{
+		glEnable(t_capability);
+		m_capabilities[t_capability] = true;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::disable(GLenum t_capability)
+{
+	std::map<GLenum, bool>::iterator it = m_capabilities.find(t_capability);
+
+	if (changed(it == m_capabilities.end() || it->second))
+	{
+		glDisable(t_capability);
+		m_capabilities[t_capability] = false;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::clearColor(GLfloat t_r, GLfloat t_g, GLfloat t_b, GLfloat t_a)
+{
+	bool different = !m_clearColorKnown
+		|| m_clearColor[0] != t_r || m_clearColor[1] != t_g
+		|| m_clearColor[2] != t_b || m_clearColor[3] != t_a;
+
+	if (changed(different))
+	{
+		glClearColor(t_r, t_g, t_b, t_a);
+		m_clearColor[0] = t_r, m_clearColor[1] = t_g, m_clearColor[2] = t_b, m_clearColor[3] = t_a;
+		m_clearColorKnown = true;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::clearDepth(GLdouble t_depth)
+{
+	if (changed(!m_clearDepthKnown || m_clearDepth != t_depth))
+	{
+		glClearDepth(t_depth);
+		m_clearDepth = t_depth;
+		m_clearDepthKnown = true;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::depthFunc(GLenum t_func)
+{
+	if (changed(m_depthFunc != t_func))
+	{
+		glDepthFunc(t_func);
+		m_depthFunc = t_func;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::depthMask(GLboolean t_write)
+{
+	if (changed(m_depthMask != t_write))
+	{
+		glDepthMask(t_write);
+		m_depthMask = t_write;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::colorMask(GLboolean t_write)
+{
+	if (changed(m_colorMask != t_write))
+	{
+		glColorMask(t_write, t_write, t_write, t_write);
+		m_colorMask = t_write;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::forgetProgram(GLuint t_program)
+{
+	if (m_program == t_program) m_program = UNKNOWN;
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::forgetVertexArray(GLuint t_vao)
+{
+	if (m_vao == t_vao)
+	{
+		m_vao = UNKNOWN;
+		m_buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::forgetBuffer(GLuint t_buffer)
+{
+	for (std::map<GLenum, GLuint>::iterator it = m_buffers.begin(); it != m_buffers.end(); ++it)
+	{
+		if (it->second == t_buffer) it->second = UNKNOWN;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void GLStateCache::forgetTexture(GLuint t_texture)
+{
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		for (std::map<GLenum, GLuint>::iterator it = m_textures[i].begin(); it != m_textures[i].end(); ++it)
+		{
+			if (it->second == t_texture) it->second = UNKNOWN;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Marks all shadowed state as unknown so the next call of each kind is issued
+/// </summary>
+void GLStateCache::invalidate()
+{
+	m_program = UNKNOWN;
+	m_vao = UNKNOWN;
+	m_activeTexture = UNKNOWN;
+	m_buffers.clear();
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		m_textures[i].clear();
+	}
+	m_capabilities.clear();
+	m_clearColorKnown = false;
+	m_clearDepthKnown = false;
+	m_depthFunc = UNKNOWN;
+	m_depthMask = UNKNOWN;
+	m_colorMask = UNKNOWN;
+}
@@ -0,0 +1,75 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <GL/glew.h>
+#include <map>
+
+/// <summary>
+/// Counts of GL state calls that reached the driver versus those dropped as redundant
+/// </summary>
+struct GLStateStats
+{
+	unsigned issued = 0;
+	unsigned elided = 0;
+};
+
+/// <summary>
+/// Shadows the GL state of one context and drops calls that would not change it.
+/// Every bind on that context must go through the cache, otherwise the shadow
+/// goes stale; call invalidate() after any code that bypasses it.
+/// </summary>
+class GLStateCache
+{
+public:
+	static const int MAX_TEXTURE_UNITS = 16;
+
+	GLStateCache();
+
+	void useProgram(GLuint t_program);
+	void bindVertexArray(GLuint t_vao);
+	void bindBuffer(GLenum t_target, GLuint t_buffer);
+	void bindTexture(GLuint t_unit, GLenum t_target, GLuint t_texture);
+	void enable(GLenum t_capability);
+	void disable(GLenum t_capability);
+	void clearColor(GLfloat t_r, GLfloat t_g, GLfloat t_b, GLfloat t_a);
+	void clearDepth(GLdouble t_depth);
+	void depthFunc(GLenum t_func);
+	void depthMask(GLboolean t_write);
+	void colorMask(GLboolean t_write); // all four channels
+
+	// Deleted names may be reused by GL, so drop them from the shadow
+	void forgetProgram(GLuint t_program);
+	void forgetVertexArray(GLuint t_vao);
+	void forgetBuffer(GLuint t_buffer);
+	void forgetTexture(GLuint t_texture);
+
+	void invalidate();
+
+	const GLStateStats& getStats() const { return m_stats; }
+	void resetStats() { m_stats = GLStateStats(); }
+
+private:
+	static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+	bool changed(bool t_different);
+
+	GLuint m_program;
+	GLuint m_vao;
+	GLuint m_activeTexture;
+	std::map<GLenum, GLuint> m_buffers;
+	std::map<GLenum, GLuint> m_textures[MAX_TEXTURE_UNITS];
+	std::map<GLenum, bool> m_capabilities;
+
+	bool m_clearColorKnown;
+	GLfloat m_clearColor[4];
+	bool m_clearDepthKnown;
+	GLdouble m_clearDepth;
+
+	GLuint m_depthFunc;
+	GLuint m_depthMask;
+	GLuint m_colorMask;
+
+	GLStateStats m_stats;
+};
+
+#endif
@@ -2,19 +2,63 @@
 
 static bool flip;
 
-Game::Game() : window(sf::VideoMode(800, 600), "OpenGL Cube Vertex and Fragment Shaders")
-{
+const std::string Game::WINDOW_TITLE{ "OpenGL Cube Vertex and Fragment Shaders" };
+const float Game::TARGET_FRAME_RATE{ 60.0f };
+const sf::Time Game::ANIMATION_INTERVAL{ sf::milliseconds(50) };
+const sf::Time Game::IDLE_POLL{ sf::milliseconds(10) };
+const unsigned Game::DEPTH_BITS{ 24 };
+const unsigned Game::STENCIL_BITS{ 8 };
+const float Game::FIELD_OF_VIEW{ 45.0f };
+const float Game::NEAR_PLANE{ 1.0f };
+const float Game::FAR_PLANE{ 500.0f };
+const unsigned Game::OCCLUSION_DOWNSCALE{ 4 };
+const size_t Game::RENDER_QUEUE_CAPACITY{ 1 << 16 };
+const uint32_t Game::GEOMETRY_VERTICES{ 1 << 16 };
+const uint32_t Game::GEOMETRY_INDEX_BYTES{ 1 << 20 };
+const std::string Game::CAPTURE_DIRECTORY{ "capture" };
+const std::string Game::SNAPSHOT_FILE{ "scene.snapshot" };
+const std::string Game::TRACE_FILE_PREFIX{ "trace" };
+const unsigned short Game::METRICS_PORT{ 9464 };
+const unsigned Game::PERF_WARMUP_FRAMES{ 60 };
+const unsigned Game::REPLAY_HOLD_FRAMES{ 30 };
+const unsigned Game::STRESS_WARMUP_FRAMES{ 10 };
+const sf::Keyboard::Key Game::REPLAY_KEYS[] = {
+	sf::Keyboard::A, sf::Keyboard::D, sf::Keyboard::W, sf::Keyboard::S, sf::Keyboard::Q, sf::Keyboard::E,
+	sf::Keyboard::Up, sf::Keyboard::Down, sf::Keyboard::Left, sf::Keyboard::Right, sf::Keyboard::Z, sf::Keyboard::X
+};
 
+Game::Game() : window(sf::VideoMode(800, 600), WINDOW_TITLE, sf::Style::Default, sf::ContextSettings(DEPTH_BITS, STENCIL_BITS))
+{
+	// Pace frames in software rather than relying on the driver's default swap interval
+	window.setVerticalSyncEnabled(m_vsync);
+	m_pacer.setTargetRate(TARGET_FRAME_RATE);
 }
 
 Game::~Game() {}
 
-void Game::run()
+/// <summary>
+/// Interactive loop until the window closes
+/// </summary>
+/// <param name="t_serveMetrics">also serve Prometheus metrics; off by default since listening opens a port</param>
+void Game::run(bool t_serveMetrics)
 {
 
 	initialize();
 
+	// Resume where the last session saved, if it did
+	if (loadSnapshot())
+	{
+		DEBUG_MSG("Resumed scene from " + SNAPSHOT_FILE);
+	}
+
+	// Prometheus endpoint, served from its own thread
+	if (t_serveMetrics && m_metricsServer.start(METRICS_PORT))
+	{
+		DEBUG_MSG("Serving metrics on http://localhost:" + std::to_string(METRICS_PORT) + "/metrics");
+	}
+
 	sf::Event event;
+	m_frameClock.restart();
 
 	while (isRunning) {
 
@@ -22,25 +66,215 @@ void Game::run()
 		DEBUG_MSG("Game running...");
 #endif
 
+#if (TRACE_ENABLED >= 1)
+		// Requested by F8 or a signal during the last frame
+		if (Trace::takeRequest())
+		{
+			saveTrace();
+		}
+#endif
+
+		// When idle in on-demand mode, block until input or the next animation frame; keep polling while assets load
+		if (m_onDemand && !m_dirty && m_loader.getPending() == 0)
+		{
+			waitForWork();
+			if (!isRunning) break;
+		}
+
+		TRACE_SCOPE("frame", "frame");
+
+		// In low latency mode this waits so input is sampled just before the deadline
+		m_pacer.beginFrame();
+
+		m_profiler.beginFrame();
+		m_metrics.recordFrameTime(m_frameClock.restart().asMicroseconds());
+
+		// Events and held keys found while building this frame mark the next one as needed
+		m_dirty = false;
+
+		m_profiler.beginPass(m_eventsPass);
 		while (window.pollEvent(event))
 		{
-			if (event.type == sf::Event::Closed)
-			{
-				isRunning = false;
-			}
+			processEvent(event);
 		}
+		m_profiler.endPass(m_eventsPass);
+
+		m_profiler.beginPass(m_updatePass);
+		m_loader.poll(m_resources);
 		update();
+		m_profiler.endPass(m_updatePass);
+
 		render();
+		m_nextAnimationFrame = clock.getElapsedTime() + ANIMATION_INTERVAL;
+
+		m_profiler.endFrame();
+		updateTitle();
+
+		m_metrics.add(FRAMES_COUNTER);
+
+		// In throughput mode this waits for the deadline
+		m_pacer.endFrame();
+	}
+
+	m_metricsServer.stop();
+
+	// Write out frames still in flight while the context is alive
+	m_capture.stop(m_glState);
+
+	unload();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Handles one window event. Anything that changes what is on screen marks the frame dirty.
+/// </summary>
+/// <param name="t_event">event from pollEvent or waitEvent</param>
+void Game::processEvent(const sf::Event& t_event)
+{
+	if (t_event.type == sf::Event::Closed)
+	{
+		isRunning = false;
+	}
+
+	// Input, or the window being shown again, needs a new frame
+	if (t_event.type == sf::Event::KeyPressed || t_event.type == sf::Event::Resized
+		|| t_event.type == sf::Event::GainedFocus || t_event.type == sf::Event::MouseEntered)
+	{
+		m_dirty = true;
+	}
+
+	// Keep the occlusion buffer at the same fraction of the new window size
+	if (t_event.type == sf::Event::Resized)
+	{
+		m_occlusion.resize(t_event.size.width / OCCLUSION_DOWNSCALE, t_event.size.height / OCCLUSION_DOWNSCALE);
+	}
+
+	// Toggle pass timings in the window title
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F1)
+	{
+		m_showTimings = !m_showTimings;
+		if (!m_showTimings) window.setTitle(WINDOW_TITLE);
+	}
+
+	// Toggle between throughput and low latency frame pacing
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F2)
+	{
+		m_pacer.setMode(m_pacer.getMode() == FramePacer::THROUGHPUT ? FramePacer::LOW_LATENCY : FramePacer::THROUGHPUT);
+		DEBUG_MSG(m_pacer.getMode() == FramePacer::LOW_LATENCY ? "Low latency pacing" : "Throughput pacing");
+	}
+
+	// Toggle vsync; the software cap is disabled while vsync paces the loop
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F3)
+	{
+		m_vsync = !m_vsync;
+		window.setVerticalSyncEnabled(m_vsync);
+		m_pacer.setTargetRate(m_vsync ? 0.0f : TARGET_FRAME_RATE);
+		DEBUG_MSG(m_vsync ? "VSync on" : "VSync off");
+	}
+
+	// Toggle on-demand rendering
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F4)
+	{
+		m_onDemand = !m_onDemand;
+		DEBUG_MSG(m_onDemand ? "On-demand rendering" : "Continuous rendering");
+	}
+
+	// Toggle animating the rainbow while on-demand rendering is idle
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F10)
+	{
+		m_idleAnimation = !m_idleAnimation;
+		DEBUG_MSG(m_idleAnimation ? "Idle animation on" : "Idle animation off");
+	}
+
+	// Toggle the depth-only pre-pass
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F6)
+	{
+		m_depthPrePass = !m_depthPrePass;
+		DEBUG_MSG(m_depthPrePass ? "Depth pre-pass on" : "Depth pre-pass off");
+	}
+
+	// Quick save and quick load of the scene
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F5)
+	{
+		if (saveSnapshot()) DEBUG_MSG("Scene saved to " + SNAPSHOT_FILE);
+	}
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F9)
+	{
+		if (loadSnapshot()) DEBUG_MSG("Scene restored from " + SNAPSHOT_FILE);
+	}
+
+	// Write the last few seconds of every thread's trace markers
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F8)
+	{
+		Trace::request();
+	}
+
+	// Start or stop recording frames to CAPTURE_DIRECTORY
+	if (t_event.type == sf::Event::KeyPressed && t_event.key.code == sf::Keyboard::F12)
+	{
+		if (m_capture.isCapturing())
+		{
+			m_capture.stop(m_glState);
+		}
+		else if (m_capture.start(window.getSize().x, window.getSize().y, CAPTURE_DIRECTORY, FrameCapture::PNG))
+		{
+			DEBUG_MSG("Capturing to " + CAPTURE_DIRECTORY);
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Blocks until an event needs a frame or the next animation frame is due.
+/// SFML 2's waitEvent() has no timeout, so it is only used when idle animation is
+/// off, the default; otherwise the thread sleeps in IDLE_POLL steps up to the deadline.
+/// </summary>
+void Game::waitForWork()
+{
+	sf::Event event;
+
+	// Nothing changes on its own unless idle animation was asked for, so sleep until input
+	if (!m_idleAnimation || ANIMATION_INTERVAL == sf::Time::Zero)
+	{
+		while (!m_dirty && isRunning && window.waitEvent(event))
+		{
+			processEvent(event);
+		}
+		return;
+	}
+
+	sf::Time remaining = m_nextAnimationFrame - clock.getElapsedTime();
+
+	while (!m_dirty && isRunning && remaining > sf::Time::Zero)
+	{
+		sf::sleep(remaining < IDLE_POLL ? remaining : IDLE_POLL);
+
+		while (window.pollEvent(event))
+		{
+			processEvent(event);
+		}
+
+		remaining = m_nextAnimationFrame - clock.getElapsedTime();
 	}
 }
 
 /////////////////////////////////////////////////////////
 
-typedef struct
+/// <summary>
+/// Shows the latest resolved pass timings in the window title, twice a second
+/// </summary>
+void Game::updateTitle()
 {
-	float coordinate[3];
-	float color[4];
-} Vertex;
+	if (m_showTimings && m_titleClock.getElapsedTime() >= sf::seconds(0.5f))
+	{
+		window.setTitle(WINDOW_TITLE + " | " + m_profiler.toString());
+		m_titleClock.restart();
+	}
+}
+
+/////////////////////////////////////////////////////////
 
 Vertex vertex[NUM_VERTICES];
 
@@ -62,36 +296,116 @@ GLubyte triangles[36] = {
 
 /////////////////////////////////////////////////////////
 
-/* Variable to hold the VBO identifier and shader data */
-GLuint	index, //Index to draw
-		vsid, //Vertex Shader ID
-		fsid, //Fragment Shader ID
-		progID, //Program ID
-		vbo = 1, // Vertex Buffer ID
-		positionID, //Position ID
-		colorID; // Color ID
-
-/////////////////////////////////////////////////////////
-
 void Game::initialize()
 {
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	gluPerspective(45.0, window.getSize().x / window.getSize().y, 1.0, 500.0);
-	glMatrixMode(GL_MODELVIEW);
+	m_glState.clearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-	glEnable(GL_CULL_FACE);
+	m_glState.enable(GL_CULL_FACE);
 
-	glTranslatef(0.0f, 0.0f, -8.0f);
+	// Nearer fragments win; needs the depth bits requested in the constructor
+	m_glState.enable(GL_DEPTH_TEST);
+	m_glState.depthFunc(GL_LESS);
+	m_glState.clearDepth(1.0);
 
+	if (window.getSettings().depthBits < DEPTH_BITS)
+	{
+		DEBUG_MSG("WARNING: Got " + std::to_string(window.getSettings().depthBits) + " depth bits, asked for " + std::to_string(DEPTH_BITS));
+	}
 
 	isRunning = true;
-	GLint isCompiled = 0;
-	GLint isLinked = 0;
+
+	// Label this thread in traces, and let a signal ask for one from outside
+	TRACE_THREAD_NAME("main");
+#if (TRACE_ENABLED >= 1)
+	Trace::installSignalHandler();
+#endif
 
 	glewInit();
 
+	// Camera matrices live in the per-frame uniform block rather than the fixed-function stack
+	float aspect = static_cast<float>(window.getSize().x) / static_cast<float>(window.getSize().y);
+	FrameUniforms::perspective(FIELD_OF_VIEW, aspect, NEAR_PLANE, FAR_PLANE, m_frameData.projection);
+	m_frameData.time = 0.0f;
+	m_frameData.deltaTime = 0.0f;
+	m_frameData.frameIndex = 0;
+	m_frameData.padding = 0.0f;
+
+	m_frameUniforms.initialize(m_glState);
+
+	// A quarter resolution depth buffer is enough to reject whole objects
+	m_occlusion.resize(window.getSize().x / OCCLUSION_DOWNSCALE, window.getSize().y / OCCLUSION_DOWNSCALE);
+
+	// CPU-only passes for the loop, CPU + GPU passes for GL work
+	m_eventsPass = m_profiler.addPass("events", false);
+	m_updatePass = m_profiler.addPass("update", false);
+	m_clearPass = m_profiler.addPass("clear", true);
+	m_drawPass = m_profiler.addPass("draw", true);
+	m_capturePass = m_profiler.addPass("capture", true);
+	m_swapPass = m_profiler.addPass("swap", true);
+
+	buildCube();
+
+	// One multi-draw per program and pool where the driver allows, one draw per object otherwise
+	const bool indirect = m_renderQueue.initializeIndirect(m_resources, m_glState);
+	DEBUG_MSG(indirect ? "Drawing with glMultiDrawElementsIndirect" : "Multi-draw indirect unavailable, drawing directly");
+
+	m_geometry.initialize(m_resources, m_glState, GEOMETRY_VERTICES, GEOMETRY_INDEX_BYTES);
+
+	/*	Shaders and geometry load in the background, so the first frame is shown straight away.
+		Each callback runs on this thread from m_loader.poll() once the upload has finished.	*/
+	m_loader.start();
+
+	// Vertex shader reads per-draw data from a storage buffer on the indirect path
+	const std::string vertexShader = indirect ? "indirect_vert_shader.phil" : "vert_shader.phil";
+
+	m_loader.loadProgram(vertexShader, "frag_shader.phil", [this](GLProgram& t_program)
+	{
+		// Share the per-frame uniform block with this program
+		m_frameUniforms.attach(t_program.name());
+		m_program = std::move(t_program);
+		m_dirty = true;
+	});
+
+	// Same vertex shader with an empty fragment shader, for the pre-pass
+	m_loader.loadProgram(vertexShader, "depth_frag_shader.phil", [this](GLProgram& t_program)
+	{
+		m_frameUniforms.attach(t_program.name());
+		m_depthProgram = std::move(t_program);
+	});
+
+	// The decoder runs on a worker, so it gets its own copy of the cube
+	std::vector<Vertex> cubeVertices(vertex, vertex + NUM_VERTICES);
+	m_loader.loadMesh([cubeVertices](MeshData& t_mesh)
+	{
+		t_mesh.vertices = cubeVertices;
+		t_mesh.indices.assign(triangles, triangles + 36);
+		t_mesh.numIndices = 36;
+		t_mesh.indexType = GL_UNSIGNED_BYTE;
+		return true;
+	},
+	[this](GLBuffer& t_vertices, GLBuffer& t_indices, const MeshData& t_mesh)
+	{
+		if (t_vertices.name() == 0) return;
+
+		/* Reserve space in the shared buffers, drawn through the pool's VAO, and copy on the GPU */
+		m_cube.load(m_geometry, m_resources, m_glState, nullptr, static_cast<GLsizei>(t_mesh.vertices.size()),
+			nullptr, t_mesh.numIndices, t_mesh.indexType);
+		if (m_cube.getPool())
+		{
+			m_geometry.copyFrom(m_glState, m_cube.getPoolId(), t_vertices.name(), t_indices.name());
+		}
+		m_metrics.add(UPLOADED_BYTES_COUNTER, sizeof(Vertex) * t_mesh.vertices.size() + t_mesh.indices.size());
+		m_dirty = true;
+	});
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Fills vertex[] with the unit cube. Needs no GL context.
+/// </summary>
+void Game::buildCube()
+{
 	// Set the coordinates of our vertices
 	vertex[0].coordinate[0] = -0.5f;
 	vertex[0].coordinate[1] = 0.5f;
@@ -158,126 +472,24 @@ void Game::initialize()
 	vertex[7].color[0] = 0.0f;
 	vertex[7].color[1] = 0.0f;
 	vertex[7].color[2] = 1.0f;
-
-	/* Create a new VBO using VBO id */
-	glGenBuffers(1, &vbo);
-
-	/* Bind the VBO */
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-	/* Upload vertex data to GPU */
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * NUM_VERTICES, vertex, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	glGenBuffers(1, &index);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLubyte) * 36, triangles, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-	/* Vertex Shader */
-	std::string vs_str;
-	loadShader("vert_shader.phil", vs_str);
-	const char* vs_src = vs_str.c_str();
-
-	DEBUG_MSG("Setting Up Vertex Shader");
-
-	vsid = glCreateShader(GL_VERTEX_SHADER); //Create Shader and set ID
-	glShaderSource(vsid, 1, (const GLchar**)&vs_src, NULL); // Set the shaders source
-	glCompileShader(vsid); //Check that the shader compiles
-
-	//Check is Shader Compiled
-	glGetShaderiv(vsid, GL_COMPILE_STATUS, &isCompiled);
-
-	if (isCompiled == GL_TRUE) {
-		DEBUG_MSG("Vertex Shader Compiled");
-		isCompiled = GL_FALSE;
-	}
-	else
-	{
-		DEBUG_MSG("ERROR: Vertex Shader Compilation Error");
-	}
-
-	/* Fragment Shader */
-	std::string fs_str;
-	loadShader("frag_shader.phil", fs_str); //Fragment Shader Src
-	const char* fs_src{ fs_str.c_str() };
-
-	DEBUG_MSG("Setting Up Fragment Shader");
-
-	fsid = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fsid, 1, (const GLchar**)&fs_src, NULL);
-	glCompileShader(fsid);
-	//Check is Shader Compiled
-	glGetShaderiv(fsid, GL_COMPILE_STATUS, &isCompiled);
-
-	if (isCompiled == GL_TRUE) {
-		DEBUG_MSG("Fragment Shader Compiled");
-		isCompiled = GL_FALSE;
-	}
-	else
-	{
-		DEBUG_MSG("ERROR: Fragment Shader Compilation Error");
-	}
-
-	DEBUG_MSG("Setting Up and Linking Shader");
-	progID = glCreateProgram();	//Create program in GPU
-	glAttachShader(progID, vsid); //Attach Vertex Shader to Program
-	glAttachShader(progID, fsid); //Attach Fragment Shader to Program
-	glLinkProgram(progID);
-
-	//Check is Shader Linked
-	glGetProgramiv(progID, GL_LINK_STATUS, &isLinked);
-
-	if (isLinked) {
-		DEBUG_MSG("Shader Linked");
-	}
-	else
-	{
-		DEBUG_MSG("ERROR: Shader Link Error");
-	}
-
-	// Use Progam on GPU
-	// https://www.opengl.org/sdk/docs/man/html/glUseProgram.xhtml
-	glUseProgram(progID);
-
-	// Find variables in the shader
-	// https://www.khronos.org/opengles/sdk/docs/man/xhtml/glGetAttribLocation.xml
-	positionID = glGetAttribLocation(progID, "sv_position");
-	colorID = glGetAttribLocation(progID, "sv_color");
 }
 
 /////////////////////////////////////////////////////////
 
-void Game::loadShader(std::string const& t_fileSrc, std::string& t_dest)
-try
+/// <summary>
+/// Live keyboard state, or the replayed key during a perf run: each of
+/// REPLAY_KEYS in turn, held for REPLAY_HOLD_FRAMES frames
+/// </summary>
+bool Game::isKeyDown(sf::Keyboard::Key t_key) const
 {
-	// Open our file
-	std::ifstream inputStream{ t_fileSrc };
-
-	// If error opening file, throw exception
-	if (!inputStream.is_open())
+	if (m_replayFrame < 0)
 	{
-		std::string msg{ "ERROR while opening shader file: " + t_fileSrc };
-		throw std::exception(msg.c_str());
+		return sf::Keyboard::isKeyPressed(t_key);
 	}
 
-	// Clear out the destination string
-	t_dest.clear();
-
-	std::string line;
+	const unsigned keyCount = sizeof(REPLAY_KEYS) / sizeof(REPLAY_KEYS[0]);
 
-	// Read each line of file into our shader string
-	while (std::getline(inputStream, line))
-	{
-		t_dest += std::string(line + "\n");
-	}
-
-	// Close our file
-	inputStream.close();
-}
-catch (const std::exception& e)
-{
-	std::cout << e.what();
+	return REPLAY_KEYS[(m_replayFrame / REPLAY_HOLD_FRAMES) % keyCount] == t_key;
 }
 
 /////////////////////////////////////////////////////////
@@ -285,8 +497,9 @@ catch (const std::exception& e)
 void Game::update()
 {
 	// Decrease y-rotation
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
+	if (isKeyDown(sf::Keyboard::A))
 	{
+		m_verticesDirty = m_dirty = true;
 		for (int i = 0; i < NUM_VERTICES; i++)
 		{
 			gpp::Vector3 tri;
@@ -294,7 +507,7 @@ void Game::update()
 			tri.y = vertex[i].coordinate[1];
 			tri.z = vertex[i].coordinate[2];
 
-			tri = gpp::Matrix3::rotationY(-0.001f) * tri;
+			tri = gpp::Matrix3::rotationY(-0.001f, gpp::FAST) * tri;
 
 			vertex[i].coordinate[0] = tri.x;
 			vertex[i].coordinate[1] = tri.y;
@@ -303,8 +516,9 @@ void Game::update()
 	}
 
 	// Increase y-rotation
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
+	if (isKeyDown(sf::Keyboard::D))
 	{
+		m_verticesDirty = m_dirty = true;
 		for (int i = 0; i < NUM_VERTICES; i++)
 		{
 			gpp::Vector3 tri;
@@ -312,7 +526,7 @@ void Game::update()
 			tri.y = vertex[i].coordinate[1];
 			tri.z = vertex[i].coordinate[2];
 
-			tri = gpp::Matrix3::rotationY(0.001f) * tri;
+			tri = gpp::Matrix3::rotationY(0.001f, gpp::FAST) * tri;
 
 			vertex[i].coordinate[0] = tri.x;
 			vertex[i].coordinate[1] = tri.y;
@@ -321,8 +535,9 @@ void Game::update()
 	}
 
 	// Decrease x-rotation
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
+	if (isKeyDown(sf::Keyboard::W))
 	{
+		m_verticesDirty = m_dirty = true;
 		for (int i = 0; i < NUM_VERTICES; i++)
 		{
 			gpp::Vector3 tri;
@@ -330,7 +545,7 @@ void Game::update()
 			tri.y = vertex[i].coordinate[1];
 			tri.z = vertex[i].coordinate[2];
 
-			tri = gpp::Matrix3::rotationX(-0.001f) * tri;
+			tri = gpp::Matrix3::rotationX(-0.001f, gpp::FAST) * tri;
 
 			vertex[i].coordinate[0] = tri.x;
 			vertex[i].coordinate[1] = tri.y;
@@ -339,8 +554,9 @@ void Game::update()
 }
 
 	// Increase x-rotation
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
+	if (isKeyDown(sf::Keyboard::S))
 	{
+		m_verticesDirty = m_dirty = true;
 		for (int i = 0; i < NUM_VERTICES; i++)
 		{
 			gpp::Vector3 tri;
@@ -348,7 +564,7 @@ void Game::update()
 			tri.y = vertex[i].coordinate[1];
 			tri.z = vertex[i].coordinate[2];
 
-			tri = gpp::Matrix3::rotationX(0.001f) * tri;
+			tri = gpp::Matrix3::rotationX(0.001f, gpp::FAST) * tri;
 
 			vertex[i].coordinate[0] = tri.x;
 			vertex[i].coordinate[1] = tri.y;
@@ -357,8 +573,9 @@ void Game::update()
 	}
 
 	// Increase z-rotation
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
+	if (isKeyDown(sf::Keyboard::Q))
 	{
+		m_verticesDirty = m_dirty = true;
 		for (int i = 0; i < NUM_VERTICES; i++)
 		{
 			gpp::Vector3 tri;
@@ -366,7 +583,7 @@ void Game::update()
 			tri.y = vertex[i].coordinate[1];
 			tri.z = vertex[i].coordinate[2];
 
-			tri = gpp::Matrix3::rotationZ(0.001f) * tri;
+			tri = gpp::Matrix3::rotationZ(0.001f, gpp::FAST) * tri;
 
 			vertex[i].coordinate[0] = tri.x;
 			vertex[i].coordinate[1] = tri.y;
@@ -375,8 +592,9 @@ void Game::update()
 	}
 
 	// Decrease z-rotation
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
+	if (isKeyDown(sf::Keyboard::E))
 	{
+		m_verticesDirty = m_dirty = true;
 		for (int i = 0; i < NUM_VERTICES; i++)
 		{
 			gpp::Vector3 tri;
@@ -384,7 +602,7 @@ void Game::update()
 			tri.y = vertex[i].coordinate[1];
 			tri.z = vertex[i].coordinate[2];
 
-			tri = gpp::Matrix3::rotationZ(-0.001f) * tri;
+			tri = gpp::Matrix3::rotationZ(-0.001f, gpp::FAST) * tri;
 
 			vertex[i].coordinate[0] = tri.x;
 			vertex[i].coordinate[1] = tri.y;
@@ -393,32 +611,37 @@ void Game::update()
 	}
 
 	// Translate up
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up))
+	if (isKeyDown(sf::Keyboard::Up))
 	{
-		glTranslatef(0.0f, 0.001f, 0.0f);
+		m_dirty = true;
+		m_translation += { 0.0f, 0.001f, 0.0f };
 	}
 
 	// Translate down
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down))
+	if (isKeyDown(sf::Keyboard::Down))
 	{
-		glTranslatef(0.0f, -0.001f, 0.0f);
+		m_dirty = true;
+		m_translation += { 0.0f, -0.001f, 0.0f };
 	}
 
 	// Translate left
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left))
+	if (isKeyDown(sf::Keyboard::Left))
 	{
-		glTranslatef(-0.001f, 0.0f, 0.0f);
+		m_dirty = true;
+		m_translation += { -0.001f, 0.0f, 0.0f };
 	}
 
 	// Translate right
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right))
+	if (isKeyDown(sf::Keyboard::Right))
 	{
-		glTranslatef(0.001f, 0.0f, 0.0f);
+		m_dirty = true;
+		m_translation += { 0.001f, 0.0f, 0.0f };
 	}
 
 	// Scale down
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Z))
+	if (isKeyDown(sf::Keyboard::Z))
 	{
+		m_verticesDirty = m_dirty = true;
 		for (int i = 0; i < NUM_VERTICES; i++)
 		{
 			gpp::Vector3 tri;
@@ -435,8 +658,9 @@ void Game::update()
 	}
 
 	// Scale up
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::X))
+	if (isKeyDown(sf::Keyboard::X))
 	{
+		m_verticesDirty = m_dirty = true;
 		for (int i = 0; i < NUM_VERTICES; i++)
 		{
 			gpp::Vector3 tri;
@@ -467,56 +691,573 @@ void Game::render()
 	DEBUG_MSG("Drawing...");
 #endif
 
+	m_profiler.beginPass(m_clearPass);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	m_profiler.endPass(m_clearPass);
+
+	m_profiler.beginPass(m_drawPass);
+
+	// Per-frame constants from the clock and the interactive camera
+	sf::Time now = clock.getElapsedTime();
+	m_frameData.deltaTime = (now - elapsed).asSeconds();
+	m_frameData.time = (now + m_timeOffset).asSeconds();
+	elapsed = now;
+	FrameUniforms::translation(m_translation.x, m_translation.y, m_translation.z, m_frameData.view);
+
+	drawScene();
+	m_profiler.endPass(m_drawPass);
+
+	// Readback is asynchronous, so this costs the same whether or not a frame is dropped
+	m_profiler.beginPass(m_capturePass);
+	m_capture.capture(m_glState);
+	m_profiler.endPass(m_capturePass);
+
+	m_profiler.beginPass(m_swapPass);
+	window.display();
+	m_profiler.endPass(m_swapPass);
+
+#if (DEBUG >= 2)
+	DEBUG_MSG("GL state calls issued: " + std::to_string(m_glState.getStats().issued)
+		+ " elided: " + std::to_string(m_glState.getStats().elided));
+#endif
+	m_glState.resetStats();
+
+	// Deletes objects released a few frames ago, once the GPU is done with them
+	m_resources.endFrame();
+
+}
+
+/////////////////////////////////////////////////////////
 
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+/// <summary>
+/// Draws the scene with the current m_frameData into the bound framebuffer
+/// </summary>
+void Game::drawScene()
+{
+	// Update per-frame constants once, shared by every program
+	m_frameUniforms.update(m_glState, m_frameData);
+	m_metrics.add(UPLOADED_BYTES_COUNTER, sizeof(FrameData));
+	m_frameData.frameIndex++;
+
+	m_glState.clearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index);
+	// Nothing to draw until the loader has delivered the program and the cube
+	if (m_program.name() == 0 || m_cube.getVAO() == 0)
+	{
+		return;
+	}
 
 	/*	As the data positions will be updated by the this program on the
 		CPU bind the updated data to the GPU for drawing	*/
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * NUM_VERTICES, vertex, GL_STATIC_DRAW);
+	if (m_verticesDirty)
+	{
+		m_cube.updateVertices(m_glState, vertex, NUM_VERTICES);
+		m_metrics.add(UPLOADED_BYTES_COUNTER, sizeof(Vertex) * NUM_VERTICES);
+		m_verticesDirty = false;
+	}
 
-	/*	Draw Triangle from VBO	(set where to start from as VBO can contain
-		model components that 'are' and 'are not' to be drawn )	*/
+	// Rainbow colour is animated in the fragment shader from FrameData.time
 
-	// Set pointers for each parameter
-	// https://www.opengl.org/sdk/docs/man4/html/glVertexAttribPointer.xhtml
-	glVertexAttribPointer(positionID, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glVertexAttribPointer(colorID, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (float*)NULL+3);
+	/*	Record draws, then sort by key so program and mesh changes are minimised.
+		Depth is the least significant field, so opaque draws sharing state go front to back.	*/
+	const float cubeDepth = sortDepth(gpp::Vector3{ 0.0f, 0.0f, 0.0f });
 
-	//Enable Arrays
-	glEnableVertexAttribArray(positionID);
-	glEnableVertexAttribArray(colorID);
+	// The cube is the only object, and nothing can be occluded by itself, so there is no occlusion pass here; see drawStress()
+	if (m_depthPrePass && m_depthProgram.name() != 0)
+	{
+		// Lay down depth only, so the colour pass shades each visible pixel once
+		m_glState.colorMask(GL_FALSE);
+		m_glState.depthMask(GL_TRUE);
+		m_glState.depthFunc(GL_LESS);
+
+		DrawPacket depthCube{ m_depthProgram.name(), &m_cube };
+		m_renderQueue.submit(RenderQueue::makeKey(DEPTH_PREPASS, m_depthProgram.name(), 0, m_cube.getVAO(), cubeDepth), depthCube);
+
+		m_renderQueue.sort();
+		m_renderQueue.execute(m_glState);
+		m_metrics.add(DRAW_CALLS_COUNTER, m_renderQueue.getDrawCalls());
+		m_renderQueue.clear();
+
+		// Only fragments matching the laid down depth are shaded
+		m_glState.colorMask(GL_TRUE);
+		m_glState.depthMask(GL_FALSE);
+		m_glState.depthFunc(GL_LEQUAL);
+	}
 
-	glUseProgram(progID); // Where program is your shader program
-	GLint uniform = glGetUniformLocation(progID, "rainbow");
-	glUniform3f(uniform, m_r, m_g, m_b);
+	DrawPacket cube{ m_program.name(), &m_cube };
+	m_renderQueue.submit(RenderQueue::makeKey(OPAQUE_PASS, m_program.name(), 0, m_cube.getVAO(), cubeDepth), cube);
 
+	m_renderQueue.sort();
+	m_renderQueue.execute(m_glState);
+	m_metrics.add(DRAW_CALLS_COUNTER, m_renderQueue.getDrawCalls());
+	m_renderQueue.clear();
 
-	// Generate sin wave
-	float sin_r{ sinf(r_theta * DEG_TO_RAD) };
-	float sin_g{ sinf(g_theta * DEG_TO_RAD) };
-	float sin_b{ sinf(b_theta * DEG_TO_RAD) };
+	// glClear only clears depth while writes are enabled
+	m_glState.depthMask(GL_TRUE);
+	m_glState.depthFunc(GL_LESS);
+}
 
-	(r_theta < 360.0f) ? r_theta += 0.1f : r_theta = 0.0f;
-	(g_theta < 360.0f) ? g_theta += 0.1f : g_theta = 0.0f;
-	(b_theta < 360.0f) ? b_theta += 0.1f : b_theta = 0.0f;
+/////////////////////////////////////////////////////////
 
-	std::cout << m_r << std::endl;
+/// <summary>
+/// Distance of a world-space point in front of the camera, as a render queue
+/// depth: 0 at the near plane, 1 at the far plane
+/// </summary>
+float Game::sortDepth(const gpp::Vector3& t_point) const
+{
+	const float* view = m_frameData.view;
+	const float viewZ = view[2] * t_point.x + view[6] * t_point.y + view[10] * t_point.z + view[14];
 
-	// Normalise to the range 0 - 1
-	m_r = (1 + sin_r) / 2.0f;
-	m_g = (1 + sin_g) / 2.0f;
-	m_b = (1 + sin_b) / 2.0f;
+	return (-viewZ - NEAR_PLANE) / (FAR_PLANE - NEAR_PLANE);
+}
 
-	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, (char*)NULL + 0);
+/////////////////////////////////////////////////////////
 
-	glUseProgram(0);
+/// <summary>
+/// Renders every frame of a camera script offscreen, as fast as possible,
+/// and writes them to disk. Nothing is presented and no input is read.
+/// Lossless capture keeps three stages in flight: while frame N renders,
+/// frame N-1 is read back into a PBO and frame N-2 is encoded by the worker.
+/// The software path renders on the CPU instead and needs no GL at all.
+/// </summary>
+/// <param name="t_script">camera script, see CameraPath</param>
+/// <param name="t_outputDirectory">created if missing</param>
+/// <param name="t_format">PNG files or a raw RGBA stream</param>
+/// <param name="t_software">render with SoftwareRasterizer</param>
+/// <returns>true if every frame was written</returns>
+bool Game::runBatch(const std::string& t_script, const std::string& t_outputDirectory, FrameCapture::Format t_format, bool t_software)
+{
+	CameraPath path;
+	if (!path.load(t_script))
+	{
+		return false;
+	}
 
-	window.display();
+	window.setVisible(false);
+
+	const unsigned width = path.getWidth();
+	const unsigned height = path.getHeight();
+	const unsigned frames = path.getFrameCount();
+
+	FrameUniforms::perspective(FIELD_OF_VIEW, static_cast<float>(width) / static_cast<float>(height), NEAR_PLANE, FAR_PLANE, m_frameData.projection);
+	m_frameData.deltaTime = 1.0f / path.getFrameRate();
+
+	m_capture.setLossless(true);
+
+	if (!m_capture.start(width, height, t_outputDirectory, t_format))
+	{
+		DEBUG_MSG("ERROR: Could not set up batch output in " + t_outputDirectory);
+		m_capture.setLossless(false);
+		return false;
+	}
+
+	sf::Clock batchClock;
+
+	if (t_software)
+	{
+		buildCube();
+
+		SoftwareRasterizer rasterizer;
+		rasterizer.resize(width, height);
+
+		for (unsigned frame = 0; frame < frames; frame++)
+		{
+			CameraPose pose = path.sample(frame);
+
+			m_frameData.time = pose.time;
+			FrameUniforms::view(pose.yaw, pose.pitch, pose.x, pose.y, pose.z, m_frameData.view);
+
+			rasterizer.clear(0.0f, 0.0f, 0.0f, 0.0f);
+			rasterizer.draw(m_frameData, vertex, NUM_VERTICES, triangles, 36, GL_UNSIGNED_BYTE);
+			rasterizer.finish();
+
+			m_capture.submit(rasterizer.getColor());
+		}
+
+		m_capture.stop(m_glState);
+	}
+	else
+	{
+		initialize();
+
+		// Every frame must be complete, so wait for the assets rather than streaming them
+		m_loader.finish(m_resources);
+
+		// Offscreen colour and depth target at the script's resolution
+		GLuint fbo;
+		GLuint renderbuffers[2];
+		glGenFramebuffers(1, &fbo);
+		glGenRenderbuffers(2, renderbuffers);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			DEBUG_MSG("ERROR: Offscreen framebuffer is incomplete");
+		}
+		else
+		{
+			// initialize() set the projection from the window, the script's size wins
+			FrameUniforms::perspective(FIELD_OF_VIEW, static_cast<float>(width) / static_cast<float>(height), NEAR_PLANE, FAR_PLANE, m_frameData.projection);
+			glViewport(0, 0, width, height);
+
+			for (unsigned frame = 0; frame < frames; frame++)
+			{
+				CameraPose pose = path.sample(frame);
+
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				m_frameData.time = pose.time;
+				FrameUniforms::view(pose.yaw, pose.pitch, pose.x, pose.y, pose.z, m_frameData.view);
+				drawScene();
+
+				m_capture.capture(m_glState);
+				m_resources.endFrame();
+			}
+		}
+
+		m_capture.stop(m_glState);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteRenderbuffers(2, renderbuffers);
+
+		unload();
+	}
+
+	m_capture.setLossless(false);
+
+	const float seconds = batchClock.getElapsedTime().asSeconds();
+	std::cout << "Rendered " << frames << " frames at " << width << "x" << height
+		<< (t_software ? " in software" : "") << " in " << seconds << " s ("
+		<< (seconds > 0.0f ? frames / seconds : 0.0f) << " fps), "
+		<< m_capture.getWritten() << " written, " << m_capture.getDropped() << " dropped" << std::endl;
+
+	return m_capture.getWritten() == frames;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Renders the fixed scene in a hidden window for t_frames frames, with the
+/// keyboard replaced by a fixed key sequence, and compares the median time of
+/// each profiler pass against a baseline file. The first PERF_WARMUP_FRAMES
+/// frames are discarded, which also covers the profiler's readback latency.
+/// </summary>
+/// <param name="t_baseline">JSON written by an earlier run, see PerfBaseline</param>
+/// <param name="t_frames">frames measured</param>
+/// <param name="t_updateBaseline">write the baseline from this run instead of comparing; the only way one is created</param>
+/// <returns>0 if nothing regressed, 1 on a regression, 2 if there is no usable baseline or it could not be written</returns>
+int Game::runPerf(const std::string& t_baseline, unsigned t_frames, bool t_updateBaseline)
+{
+	// Checked before rendering so a missing baseline fails fast rather than passing silently
+	PerfBaseline baseline;
+	if (!t_updateBaseline && !baseline.load(t_baseline))
+	{
+		std::cout << "No usable baseline at " << t_baseline << "; run with --update-baseline to create it" << std::endl;
+		return 2;
+	}
+
+	window.setVisible(false);
+
+	initialize();
+	m_loader.finish(m_resources);
+
+	// Everything a frame does except event handling, which headless has none of
+	const int passes[] = { m_updatePass, m_clearPass, m_drawPass, m_swapPass };
+	const int numPasses = sizeof(passes) / sizeof(passes[0]);
+	std::vector<double> cpuSamples[numPasses], gpuSamples[numPasses];
+
+	for (unsigned frame = 0; frame < PERF_WARMUP_FRAMES + t_frames; frame++)
+	{
+		m_replayFrame = static_cast<int>(frame);
+
+		m_profiler.beginFrame();
+
+		m_profiler.beginPass(m_updatePass);
+		update();
+		m_profiler.endPass(m_updatePass);
+
+		render();
+		m_profiler.endFrame();
+
+		if (frame < PERF_WARMUP_FRAMES) continue;
+
+		for (int i = 0; i < numPasses; i++)
+		{
+			cpuSamples[i].push_back(m_profiler.getTiming(passes[i]).cpuMs);
+			if (passes[i] != m_updatePass) gpuSamples[i].push_back(m_profiler.getTiming(passes[i]).gpuMs);
+		}
+	}
+
+	m_replayFrame = -1;
+	unload();
+
+	PerfBaseline current;
+	current.frames = t_frames;
+	for (int i = 0; i < numPasses; i++)
+	{
+		current.stats.push_back(PerfBaseline::summarize(m_profiler.getPassName(passes[i]) + " cpu", cpuSamples[i]));
+		if (!gpuSamples[i].empty())
+		{
+			current.stats.push_back(PerfBaseline::summarize(m_profiler.getPassName(passes[i]) + " gpu", gpuSamples[i]));
+		}
+	}
+
+	if (t_updateBaseline)
+	{
+		if (!current.save(t_baseline))
+		{
+			return 2;
+		}
+
+		std::cout << "Updated " << t_baseline << " from " << t_frames << " frames; commit it to guard against regressions" << std::endl;
+		return 0;
+	}
+
+	if (baseline.frames != t_frames)
+	{
+		std::cout << "Note: baseline was measured over " << baseline.frames << " frames, this run " << t_frames << std::endl;
+	}
 
+	const int regressions = baseline.compare(current, std::cout);
+	std::cout << (regressions > 0 ? std::to_string(regressions) + " phase(s) regressed" : std::string("No regressions")) << std::endl;
+
+	return regressions > 0 ? 1 : 0;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Renders generated scenes of each object count in a hidden window and
+/// reports how frame time scales with N. Every scene uses one mesh built
+/// from the cube, drawn once per object with its own model matrix; unless
+/// t_params turns it off, the occluders cull the objects hidden behind them.
+/// </summary>
+/// <param name="t_params">mesh complexity, distribution, animated and occluder fractions</param>
+/// <param name="t_counts">object counts to sweep</param>
+/// <param name="t_frames">frames measured per count, after STRESS_WARMUP_FRAMES</param>
+/// <param name="t_output">CSV of the sweep, one row per count</param>
+/// <returns>true if every count ran and the CSV was written</returns>
+bool Game::runStress(const StressParams& t_params, const std::vector<unsigned>& t_counts, unsigned t_frames, const std::string& t_output)
+{
+	window.setVisible(false);
+	m_occlusionCulling = t_params.occlusionCulling;
+
+	initialize();
+	m_loader.finish(m_resources);
+
+	if (m_program.name() == 0)
+	{
+		unload();
+		return false;
+	}
+
+	MeshData meshData;
+	StressScene::buildMesh(vertex, triangles, 12, t_params.complexity, meshData);
+
+	Mesh mesh;
+	mesh.load(m_geometry, m_resources, m_glState, meshData.vertices.data(), static_cast<GLsizei>(meshData.vertices.size()),
+		meshData.indices.data(), meshData.numIndices, meshData.indexType);
+
+	std::cout << "Stress mesh: " << meshData.numIndices / 3 << " triangles, " << meshData.vertices.size() << " vertices" << std::endl;
+
+	std::vector<StressResult> results;
+	bool complete = true;
+
+	for (unsigned count : t_counts)
+	{
+		StressScene scene;
+		scene.generate(t_params, count);
+
+		// Far enough back that the whole field is in view
+		FrameUniforms::translation(0.0f, 0.0f, -(4.0f * scene.getExtent() + 2.0f), m_frameData.view);
+
+		StressResult total;
+		std::vector<double> frameSamples, cpuSamples;
+		unsigned dropped = 0;
+
+		for (unsigned frame = 0; frame < STRESS_WARMUP_FRAMES + t_frames; frame++)
+		{
+			StressResult sample;
+			sf::Clock frameClock;
+
+			m_frameData.time = frame / TARGET_FRAME_RATE;
+			scene.animate(m_frameData.time);
+
+			dropped = std::max(dropped, drawStress(scene, mesh, sample));
+			const double cpuMs = frameClock.getElapsedTime().asMicroseconds() / 1000.0;
+
+			window.display();
+			glFinish();
+			const double frameMs = frameClock.getElapsedTime().asMicroseconds() / 1000.0;
+
+			m_resources.endFrame();
+
+			if (frame < STRESS_WARMUP_FRAMES) continue;
+
+			total.drawn += sample.drawn / t_frames;
+			total.culled += sample.culled / t_frames;
+			total.drawCalls += sample.drawCalls / t_frames;
+			cpuSamples.push_back(cpuMs);
+			frameSamples.push_back(frameMs);
+		}
+
+		if (dropped > 0)
+		{
+			DEBUG_MSG("WARNING: " + std::to_string(dropped) + " of " + std::to_string(count) + " objects did not fit in the render queue");
+			complete = false;
+		}
+
+		total.objects = count;
+		total.triangles = total.drawn * (meshData.numIndices / 3);
+		total.frameMs = PerfBaseline::summarize("frame", frameSamples).median;
+		total.cpuMs = PerfBaseline::summarize("cpu", cpuSamples).median;
+		results.push_back(total);
+
+		DEBUG_MSG(std::to_string(count) + " objects: " + std::to_string(total.frameMs) + " ms");
+	}
+
+	mesh.unload();
+	unload();
+
+	StressScene::report(results, std::cout);
+	return StressScene::saveCsv(t_output, results) && complete;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Clears and draws one frame of a stress scene with the current m_frameData.
+/// Occluders are rasterized into the culling pyramid and always drawn; every
+/// other object is tested against it first.
+/// </summary>
+/// <param name="t_result">drawn, culled and draw calls are added to</param>
+/// <returns>objects that did not fit in the render queue</returns>
+unsigned Game::drawStress(const StressScene& t_scene, const Mesh& t_mesh, StressResult& t_result)
+{
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	m_frameUniforms.update(m_glState, m_frameData);
+	m_frameData.frameIndex++;
+
+	if (m_occlusionCulling)
+	{
+		float viewProjection[16];
+		FrameUniforms::multiply(m_frameData.projection, m_frameData.view, viewProjection);
+
+		m_occlusion.beginFrame(viewProjection);
+		for (size_t i = 0; i < t_scene.size() && t_scene.getObject(i).occluder; i++)
+		{
+			m_occlusion.addOccluder(t_scene.getBounds(i));
+		}
+		m_occlusion.buildPyramid();
+	}
+
+	for (size_t i = 0; i < t_scene.size(); i++)
+	{
+		const StressObject& object = t_scene.getObject(i);
+
+		if (m_occlusionCulling && !object.occluder && !m_occlusion.isVisible(t_scene.getBounds(i)))
+		{
+			t_result.culled++;
+			continue;
+		}
+
+		const float depth = sortDepth(gpp::Vector3{ object.position[0], object.position[1], object.position[2] });
+		DrawPacket packet{ m_program.name(), &t_mesh, t_scene.getDrawData(i) };
+		if (m_renderQueue.submit(RenderQueue::makeKey(OPAQUE_PASS, m_program.name(), 0, t_mesh.getVAO(), depth), packet))
+		{
+			t_result.drawn++;
+		}
+	}
+
+	m_renderQueue.sort();
+	m_renderQueue.execute(m_glState);
+	t_result.drawCalls += m_renderQueue.getDrawCalls();
+	const unsigned dropped = m_renderQueue.getDropped();
+	m_renderQueue.clear();
+
+	return dropped;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Writes the cube's vertices, translation and animation time as a snapshot
+/// </summary>
+/// <returns>true if the file was written</returns>
+bool Game::saveSnapshot()
+{
+	const uint32_t cubeMesh = 0;
+	const uint32_t firstVertex = 0;
+	const uint32_t vertexCount = NUM_VERTICES;
+	const float animationTime = (clock.getElapsedTime() + m_timeOffset).asSeconds();
+
+	SceneState state;
+	state.objectCount = 1;
+	state.translationX = &m_translation.x;
+	state.translationY = &m_translation.y;
+	state.translationZ = &m_translation.z;
+	state.mesh = &cubeMesh;
+	state.animationTime = &animationTime;
+	state.meshCount = 1;
+	state.meshFirstVertex = &firstVertex;
+	state.meshVertexCount = &vertexCount;
+	state.vertexCount = NUM_VERTICES;
+	state.vertices = vertex;
+
+	return SceneSnapshot::save(SNAPSHOT_FILE, state);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Maps the snapshot and copies its state into the scene. Files that do
+/// not describe a single cube of NUM_VERTICES vertices are ignored.
+/// </summary>
+/// <returns>true if the scene was restored</returns>
+bool Game::loadSnapshot()
+{
+	SceneSnapshot snapshot;
+	if (!snapshot.open(SNAPSHOT_FILE)) return false;
+
+	const SceneState& state = snapshot.getState();
+	if (state.objectCount != 1 || state.meshVertexCount[state.mesh[0]] != NUM_VERTICES)
+	{
+		DEBUG_MSG("ERROR: Snapshot does not match this scene: " + SNAPSHOT_FILE);
+		return false;
+	}
+
+	std::copy(state.vertices + state.meshFirstVertex[state.mesh[0]],
+		state.vertices + state.meshFirstVertex[state.mesh[0]] + NUM_VERTICES, vertex);
+	m_translation = { state.translationX[0], state.translationY[0], state.translationZ[0] };
+	m_timeOffset = sf::seconds(state.animationTime[0]) - clock.getElapsedTime();
+
+	m_verticesDirty = m_dirty = true;
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Writes every thread's recent trace markers to TRACE_FILE_PREFIX-<unix time>.json
+/// </summary>
+void Game::saveTrace()
+{
+	const std::string fileSrc = TRACE_FILE_PREFIX + "-" + std::to_string(static_cast<long long>(std::time(nullptr))) + ".json";
+
+	if (Trace::save(fileSrc))
+	{
+		DEBUG_MSG("Open " + fileSrc + " in ui.perfetto.dev or chrome://tracing");
+	}
 }
 
 /////////////////////////////////////////////////////////
@@ -526,6 +1267,16 @@ void Game::unload()
 #if (DEBUG >= 2)
 	DEBUG_MSG("Cleaning up...");
 #endif
-	glDeleteProgram(progID);
-	glDeleteBuffers(1, &vbo);
+	m_loader.stop(m_resources);
+	m_program.reset();
+	m_depthProgram.reset();
+	m_cube.unload();
+	m_geometry.unload();
+	m_renderQueue.unloadIndirect();
+	m_frameUniforms.unload(m_glState);
+	m_profiler.unload();
+
+	// Anything still live here was never released, and is reported as a leak
+	m_resources.shutdown();
+	DEBUG_MSG("GL resources after shutdown: " + m_resources.toString());
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <Debug.h>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <GL/glew.h>
@@ -12,34 +13,133 @@
 
 #include <Vector3.h>
 #include <Matrix3.h>
+#include <GLStateCache.h>
+#include <GLResources.h>
+#include <FrameUniforms.h>
+#include <Mesh.h>
+#include <GeometryPool.h>
+#include <RenderQueue.h>
+#include <FrameProfiler.h>
+#include <FramePacer.h>
+#include <SceneSnapshot.h>
+#include <FrameCapture.h>
+#include <CameraPath.h>
+#include <SoftwareRasterizer.h>
+#include <OcclusionCuller.h>
+#include <AssetLoader.h>
+#include <Metrics.h>
+#include <MetricsServer.h>
+#include <PerfBaseline.h>
+#include <StressScene.h>
+#include <Trace.h>
+
+#include <ctime>
 
 class Game
 {
 public:
 	Game();
 	~Game();
-	void run();
+	void run(bool t_serveMetrics = false);
+	bool runBatch(const std::string& t_script, const std::string& t_outputDirectory, FrameCapture::Format t_format, bool t_software = false);
+	int runPerf(const std::string& t_baseline, unsigned t_frames, bool t_updateBaseline);
+	bool runStress(const StressParams& t_params, const std::vector<unsigned>& t_counts, unsigned t_frames, const std::string& t_output);
 private:
 	sf::Window window;
 	bool isRunning = false;
 	void initialize();
-	void loadShader(std::string const& t_fileSrc, std::string& t_dest);
+	void buildCube();
+	void processEvent(const sf::Event& t_event);
+	void waitForWork();
+	bool isKeyDown(sf::Keyboard::Key t_key) const;
 	void update();
 	void render();
+	void drawScene();
+	unsigned drawStress(const StressScene& t_scene, const Mesh& t_mesh, StressResult& t_result);
+	float sortDepth(const gpp::Vector3& t_point) const;
 	void unload();
+	void updateTitle();
+	bool saveSnapshot();
+	bool loadSnapshot();
+	void saveTrace();
 
 	sf::Clock clock;
 	sf::Time elapsed;
 
-	const double DEG_TO_RAD{ 3.14159265 / 180.0f };
+	GLStateCache m_glState;
+	GLResources m_resources{ m_glState }; // declared before anything holding its handles
+
+	GLProgram m_program;
+	GLProgram m_depthProgram; // same vertex shader, empty fragment shader, for the pre-pass
+	GeometryPool m_geometry; // shared vertex and index buffers for every mesh
+	Mesh m_cube;
+	AssetLoader m_loader; // programs and meshes arrive through callbacks on this thread
+	RenderQueue m_renderQueue{ RENDER_QUEUE_CAPACITY };
+
+	FrameProfiler m_profiler;
+	int m_eventsPass, m_updatePass, m_clearPass, m_drawPass, m_capturePass, m_swapPass;
+	bool m_showTimings = false; // toggled with F1
+	sf::Clock m_titleClock;
+
+	FramePacer m_pacer;
+	bool m_vsync = false; // toggled with F3, replaces the software cap when on
+
+	bool m_onDemand = false; // toggled with F4, only render when something changed
+	bool m_idleAnimation = false; // toggled with F10, keep the rainbow animating while on-demand is idle
+	bool m_dirty = true; // a frame is needed
+	bool m_verticesDirty = false; // vertex data changed on the CPU and must be re-uploaded
+	sf::Time m_nextAnimationFrame;
+
+	FrameCapture m_capture; // toggled with F12
+
+	bool m_depthPrePass = false; // toggled with F6
 
-	float m_r, m_g, m_b;
+	Metrics m_metrics;
+	MetricsServer m_metricsServer{ m_metrics };
+	sf::Clock m_frameClock; // start of the previous frame, for the frame time histogram
 
-	float r_theta{ 240.0f };
-	float g_theta{ 120.0f };
-	float b_theta{ 0.0f };
+	OcclusionCuller m_occlusion;
+	bool m_occlusionCulling = true; // stress scene only, from StressParams
+
+	// Render queue passes, drawn in this order
+	enum RenderPass
+	{
+		DEPTH_PREPASS,
+		OPAQUE_PASS
+	};
+
+	FrameUniforms m_frameUniforms;
+	FrameData m_frameData;
+
+	gpp::Vector3 m_translation{ 0.0f, 0.0f, -8.0f };
+
+	sf::Time m_timeOffset; // added to the clock so a resumed snapshot continues its animation
 
 	float rotationAngle = 0.0f;
+
+	int m_replayFrame = -1; // frame of the replayed input during a perf run, -1 for the live keyboard
+
+	static const std::string WINDOW_TITLE;
+	static const float TARGET_FRAME_RATE;
+	static const sf::Time ANIMATION_INTERVAL; // redraw rate of the rainbow while idle with m_idleAnimation on
+	static const sf::Time IDLE_POLL; // event polling granularity while waiting for an animation frame
+	static const unsigned DEPTH_BITS;
+	static const unsigned STENCIL_BITS;
+	static const float FIELD_OF_VIEW; // vertical, degrees
+	static const float NEAR_PLANE;
+	static const float FAR_PLANE;
+	static const unsigned OCCLUSION_DOWNSCALE; // window size / occlusion buffer size
+	static const size_t RENDER_QUEUE_CAPACITY; // draws per flush, more are dropped
+	static const uint32_t GEOMETRY_VERTICES; // initial geometry pool size, grows on demand
+	static const uint32_t GEOMETRY_INDEX_BYTES;
+	static const std::string CAPTURE_DIRECTORY;
+	static const std::string SNAPSHOT_FILE; // saved with F5, restored with F9 and on startup
+	static const std::string TRACE_FILE_PREFIX; // F8 or SIGUSR1 writes PREFIX-<time>.json
+	static const unsigned short METRICS_PORT; // Prometheus scrape endpoint on localhost, opened by run(true)
+	static const unsigned PERF_WARMUP_FRAMES; // rendered but not measured by runPerf
+	static const unsigned REPLAY_HOLD_FRAMES; // frames each replayed key is held
+	static const sf::Keyboard::Key REPLAY_KEYS[12]; // every key update() reacts to
+	static const unsigned STRESS_WARMUP_FRAMES; // rendered but not measured for each object count
 };
 
 const int NUM_VERTICES{ 8 };
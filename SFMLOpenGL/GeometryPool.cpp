@@ -0,0 +1,321 @@
+#include <GeometryPool.h>
+#include <Debug.h>
+
+#include <algorithm>
+#include <iostream>
+
+GeometryPool::GeometryPool() :
+	m_layout{ Mesh::DEFAULT_LAYOUT },
+	m_numAttributes{ 2 },
+	m_reallocations{ 0 }
+{
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Allocates empty buffers and sets up the shared VAO
+/// </summary>
+/// <param name="t_vertexCapacity">initial size of the vertex buffer, in vertices</param>
+/// <param name="t_indexCapacity">initial size of the index buffer, in bytes</param>
+/// <param name="t_layout">attributes of every mesh in the pool</param>
+/// <param name="t_numAttributes">number of entries in t_layout</param>
+void GeometryPool::initialize(GLResources& t_resources, GLStateCache& t_state, uint32_t t_vertexCapacity, uint32_t t_indexCapacity,
+	const VertexAttribute* t_layout, int t_numAttributes)
+{
+	m_layout = t_layout;
+	m_numAttributes = t_numAttributes;
+	m_ranges.clear();
+	m_freeIds.clear();
+
+	reallocate(t_resources, t_state, t_vertexCapacity, t_indexCapacity);
+	m_reallocations = 0;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Copies a mesh into the pool. If either buffer has no room, the pool is
+/// compacted first, and grown if compacting would not be enough.
+/// </summary>
+/// <param name="t_vertices">vertex data, or null to only reserve the space</param>
+/// <param name="t_indices">indices relative to the first of t_vertices, or null</param>
+/// <param name="t_indexType">GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT</param>
+/// <returns>ID for draw(), updateVertices() and free()</returns>
+uint32_t GeometryPool::allocate(GLResources& t_resources, GLStateCache& t_state, const Vertex* t_vertices, GLsizei t_numVertices,
+	const void* t_indices, GLsizei t_numIndices, GLenum t_indexType)
+{
+	if (m_vertexBuffer.name() == 0 || t_numVertices <= 0 || t_numIndices <= 0)
+	{
+		return INVALID;
+	}
+
+	GeometryRange range;
+	range.numVertices = t_numVertices;
+	range.numIndices = t_numIndices;
+	range.indexType = t_indexType;
+	range.live = true;
+
+	const uint32_t indexBytes = static_cast<uint32_t>(t_numIndices * Mesh::indexSize(t_indexType));
+
+	if (!place(range, indexBytes))
+	{
+		// Compacting removes every gap; grow only the buffer that would still be short
+		const BufferAllocatorStats vertexStats = m_vertexAllocator.getStats();
+		const BufferAllocatorStats indexStats = m_indexAllocator.getStats();
+		const uint32_t vertexNeeded = vertexStats.used + t_numVertices;
+		const uint32_t indexNeeded = indexStats.used + indexBytes + Mesh::indexSize(t_indexType);
+
+		reallocate(t_resources, t_state,
+			vertexNeeded <= vertexStats.capacity ? vertexStats.capacity : std::max(vertexStats.capacity * 2, vertexNeeded),
+			indexNeeded <= indexStats.capacity ? indexStats.capacity : std::max(indexStats.capacity * 2, indexNeeded));
+
+		if (!place(range, indexBytes))
+		{
+			DEBUG_MSG("ERROR: Geometry pool could not fit a mesh of " + std::to_string(t_numVertices) + " vertices");
+			return INVALID;
+		}
+	}
+
+	if (t_vertices)
+	{
+		t_state.bindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer.name());
+		glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex) * range.baseVertex, sizeof(Vertex) * t_numVertices, t_vertices);
+	}
+
+	if (t_indices)
+	{
+		// Not GL_ELEMENT_ARRAY_BUFFER, which would change whichever VAO is bound
+		t_state.bindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer.name());
+		glBufferSubData(GL_COPY_WRITE_BUFFER, range.indexOffset, indexBytes, t_indices);
+	}
+
+	uint32_t id;
+	if (!m_freeIds.empty())
+	{
+		id = m_freeIds.back();
+		m_freeIds.pop_back();
+		m_ranges[id] = range;
+	}
+	else
+	{
+		id = static_cast<uint32_t>(m_ranges.size());
+		m_ranges.push_back(range);
+	}
+
+	return id;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Re-uploads the vertices of one mesh; at most as many as it was allocated with
+/// </summary>
+void GeometryPool::updateVertices(GLStateCache& t_state, uint32_t t_id, const Vertex* t_vertices, GLsizei t_numVertices)
+{
+	const GeometryRange& range = m_ranges[t_id];
+
+	t_state.bindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer.name());
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex) * range.baseVertex,
+		sizeof(Vertex) * std::min(t_numVertices, range.numVertices), t_vertices);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Fills a mesh's space from buffers already on the GPU, such as staging
+/// buffers from AssetLoader, without a round trip through the CPU
+/// </summary>
+/// <param name="t_vertices">buffer holding the mesh's vertices from offset 0</param>
+/// <param name="t_indices">buffer holding its indices from offset 0</param>
+void GeometryPool::copyFrom(GLStateCache& t_state, uint32_t t_id, GLuint t_vertices, GLuint t_indices)
+{
+	const GeometryRange& range = m_ranges[t_id];
+
+	t_state.bindBuffer(GL_COPY_READ_BUFFER, t_vertices);
+	t_state.bindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer.name());
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, sizeof(Vertex) * range.baseVertex, sizeof(Vertex) * range.numVertices);
+
+	t_state.bindBuffer(GL_COPY_READ_BUFFER, t_indices);
+	t_state.bindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer.name());
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, range.indexOffset, range.numIndices * Mesh::indexSize(range.indexType));
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Returns a mesh's space to the pool. The ID may be handed out again.
+/// </summary>
+void GeometryPool::free(uint32_t t_id)
+{
+	if (t_id >= m_ranges.size() || !m_ranges[t_id].live)
+	{
+		return;
+	}
+
+	m_vertexAllocator.free(static_cast<uint32_t>(m_ranges[t_id].baseVertex));
+	m_indexAllocator.free(static_cast<uint32_t>(m_ranges[t_id].indexOffset));
+	m_ranges[t_id].live = false;
+	m_freeIds.push_back(t_id);
+}
+
+/////////////////////////////////////////////////////////
+
+void GeometryPool::draw(GLStateCache& t_state, uint32_t t_id) const
+{
+	const GeometryRange& range = m_ranges[t_id];
+
+	t_state.bindVertexArray(m_vao.name());
+	glDrawElementsBaseVertex(GL_TRIANGLES, range.numIndices, range.indexType,
+		(char*)NULL + range.indexOffset, range.baseVertex);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Packs every live mesh to the front of fresh buffers of the same size,
+/// leaving one free range at the end of each
+/// </summary>
+void GeometryPool::defragment(GLResources& t_resources, GLStateCache& t_state)
+{
+	reallocate(t_resources, t_state, m_vertexAllocator.getCapacity(), m_indexAllocator.getCapacity());
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Releases the buffers and VAO. Mesh IDs are no longer valid.
+/// </summary>
+void GeometryPool::unload()
+{
+	m_vao.reset();
+	m_vertexBuffer.reset();
+	m_indexBuffer.reset();
+	m_vertexAllocator.reset(0);
+	m_indexAllocator.reset(0);
+	m_ranges.clear();
+	m_freeIds.clear();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Reserves space for a range in both allocators, all or nothing
+/// </summary>
+bool GeometryPool::place(GeometryRange& t_range, uint32_t t_indexBytes)
+{
+	const uint32_t baseVertex = m_vertexAllocator.allocate(t_range.numVertices);
+	if (baseVertex == BufferAllocator::INVALID)
+	{
+		return false;
+	}
+
+	const uint32_t indexOffset = m_indexAllocator.allocate(t_indexBytes, Mesh::indexSize(t_range.indexType));
+	if (indexOffset == BufferAllocator::INVALID)
+	{
+		m_vertexAllocator.free(baseVertex);
+		return false;
+	}
+
+	t_range.baseVertex = static_cast<GLint>(baseVertex);
+	t_range.indexOffset = indexOffset;
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Moves every live mesh into new buffers of at least the given capacities,
+/// packed in ID order, and rebuilds the VAO around them. The old objects are released
+/// to GLResources, which deletes them once draws already queued are done.
+/// </summary>
+void GeometryPool::reallocate(GLResources& t_resources, GLStateCache& t_state, uint32_t t_vertexCapacity, uint32_t t_indexCapacity)
+{
+	BufferAllocator vertexAllocator(t_vertexCapacity);
+	BufferAllocator indexAllocator(t_indexCapacity);
+	std::vector<GeometryRange> ranges = m_ranges;
+
+	// Alignment padding between index ranges can still leave a buffer short,
+	// so grow whichever one ran out and pack everything again
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		GeometryRange& range = ranges[i];
+		if (!range.live) continue;
+
+		const uint32_t indexBytes = static_cast<uint32_t>(range.numIndices * Mesh::indexSize(range.indexType));
+		const uint32_t baseVertex = vertexAllocator.allocate(range.numVertices);
+		const uint32_t indexOffset = indexAllocator.allocate(indexBytes, Mesh::indexSize(range.indexType));
+
+		if (baseVertex == BufferAllocator::INVALID || indexOffset == BufferAllocator::INVALID)
+		{
+			if (baseVertex == BufferAllocator::INVALID) t_vertexCapacity = std::max(t_vertexCapacity * 2, t_vertexCapacity + range.numVertices);
+			if (indexOffset == BufferAllocator::INVALID) t_indexCapacity = std::max(t_indexCapacity * 2, t_indexCapacity + indexBytes + Mesh::indexSize(range.indexType));
+
+			vertexAllocator.reset(t_vertexCapacity);
+			indexAllocator.reset(t_indexCapacity);
+			ranges = m_ranges;
+			i = static_cast<size_t>(-1); // restart from the first range
+			continue;
+		}
+
+		range.baseVertex = static_cast<GLint>(baseVertex);
+		range.indexOffset = indexOffset;
+	}
+
+	GLBuffer vertexBuffer = t_resources.createBuffer();
+	GLBuffer indexBuffer = t_resources.createBuffer();
+	t_resources.bufferData(vertexBuffer.handle(), GL_COPY_WRITE_BUFFER, sizeof(Vertex) * t_vertexCapacity, NULL, GL_DYNAMIC_DRAW);
+	t_resources.bufferData(indexBuffer.handle(), GL_COPY_WRITE_BUFFER, t_indexCapacity, NULL, GL_STATIC_DRAW);
+
+	// Copy on the GPU: vertices first, then indices
+	for (int pass = 0; pass < 2 && m_vertexBuffer.name() != 0; pass++)
+	{
+		t_state.bindBuffer(GL_COPY_READ_BUFFER, (pass == 0 ? m_vertexBuffer : m_indexBuffer).name());
+		t_state.bindBuffer(GL_COPY_WRITE_BUFFER, (pass == 0 ? vertexBuffer : indexBuffer).name());
+
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			if (!ranges[i].live) continue;
+
+			if (pass == 0)
+			{
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sizeof(Vertex) * m_ranges[i].baseVertex,
+					sizeof(Vertex) * ranges[i].baseVertex, sizeof(Vertex) * ranges[i].numVertices);
+			}
+			else
+			{
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, m_ranges[i].indexOffset,
+					ranges[i].indexOffset, ranges[i].numIndices * Mesh::indexSize(ranges[i].indexType));
+			}
+		}
+	}
+
+	GLVertexArray vao = t_resources.createVertexArray();
+	t_state.bindVertexArray(vao.name());
+	t_state.bindBuffer(GL_ARRAY_BUFFER, vertexBuffer.name());
+
+	for (int i = 0; i < m_numAttributes; i++)
+	{
+		const VertexAttribute& attribute = m_layout[i];
+		glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized,
+			sizeof(Vertex), (char*)NULL + attribute.offset);
+		glEnableVertexAttribArray(attribute.location);
+	}
+
+	// The element buffer binding is VAO state, so leave it bound
+	t_state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.name());
+	t_state.bindVertexArray(0);
+
+	m_vao = std::move(vao);
+	m_vertexBuffer = std::move(vertexBuffer);
+	m_indexBuffer = std::move(indexBuffer);
+	m_vertexAllocator = vertexAllocator;
+	m_indexAllocator = indexAllocator;
+	m_ranges.swap(ranges);
+	m_reallocations++;
+
+#if (DEBUG >= 2)
+	DEBUG_MSG("Geometry pool reallocated to " + std::to_string(t_vertexCapacity) + " vertices, "
+		+ std::to_string(t_indexCapacity) + " index bytes");
+#endif
+}
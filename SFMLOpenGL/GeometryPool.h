@@ -0,0 +1,85 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <GL/glew.h>
+#include <GLStateCache.h>
+#include <GLResources.h>
+#include <BufferAllocator.h>
+#include <Mesh.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// Where one mesh lives inside the pool's buffers
+/// </summary>
+struct GeometryRange
+{
+	GLint baseVertex; // added to every index by glDrawElementsBaseVertex
+	GLsizei numVertices;
+	size_t indexOffset; // bytes into the index buffer
+	GLsizei numIndices;
+	GLenum indexType;
+	bool live;
+};
+
+/// <summary>
+/// Stores many meshes in one vertex buffer and one index buffer, sharing a
+/// single VAO. Space is handed out by BufferAllocator, in vertices for the
+/// vertex buffer and in bytes, aligned to the index size, for the index buffer.
+/// Indices stay relative to their own mesh and are offset at draw time with
+/// glDrawElementsBaseVertex, so every mesh draws with the same bindings.
+///
+/// Meshes are referred to by ID rather than by offset: when an allocation
+/// does not fit, the pool compacts into fresh buffers with glCopyBufferSubData,
+/// growing them if the free space is not enough, and only the ID table changes.
+/// </summary>
+class GeometryPool
+{
+public:
+	static const uint32_t INVALID = BufferAllocator::INVALID;
+
+	GeometryPool();
+
+	void initialize(GLResources& t_resources, GLStateCache& t_state, uint32_t t_vertexCapacity, uint32_t t_indexCapacity,
+		const VertexAttribute* t_layout = Mesh::DEFAULT_LAYOUT, int t_numAttributes = 2);
+
+	// Returns the mesh ID, or INVALID if the pool is not initialized
+	uint32_t allocate(GLResources& t_resources, GLStateCache& t_state, const Vertex* t_vertices, GLsizei t_numVertices,
+		const void* t_indices, GLsizei t_numIndices, GLenum t_indexType);
+	void updateVertices(GLStateCache& t_state, uint32_t t_id, const Vertex* t_vertices, GLsizei t_numVertices);
+	void copyFrom(GLStateCache& t_state, uint32_t t_id, GLuint t_vertices, GLuint t_indices);
+	void free(uint32_t t_id);
+
+	void draw(GLStateCache& t_state, uint32_t t_id) const;
+
+	void defragment(GLResources& t_resources, GLStateCache& t_state);
+	void unload();
+
+	GLuint getVAO() const { return m_vao.name(); }
+	const GeometryRange& getRange(uint32_t t_id) const { return m_ranges[t_id]; }
+	BufferAllocatorStats getVertexStats() const { return m_vertexAllocator.getStats(); }
+	BufferAllocatorStats getIndexStats() const { return m_indexAllocator.getStats(); }
+	unsigned getReallocations() const { return m_reallocations; }
+
+private:
+	bool place(GeometryRange& t_range, uint32_t t_indexBytes);
+	void reallocate(GLResources& t_resources, GLStateCache& t_state, uint32_t t_vertexCapacity, uint32_t t_indexCapacity);
+
+	GLVertexArray m_vao;
+	GLBuffer m_vertexBuffer;
+	GLBuffer m_indexBuffer;
+
+	BufferAllocator m_vertexAllocator; // in vertices
+	BufferAllocator m_indexAllocator; // in bytes
+
+	std::vector<GeometryRange> m_ranges; // indexed by mesh ID
+	std::vector<uint32_t> m_freeIds;
+
+	const VertexAttribute* m_layout;
+	int m_numAttributes;
+	unsigned m_reallocations;
+};
+
+#endif
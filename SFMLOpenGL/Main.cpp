@@ -1,7 +1,104 @@
 #include <Game.h>
+#include <MathSelfTest.h>
+#include <SelfTest.h>
 
-int main(void)
+#include <cstdlib>
+
+/// <summary>
+/// Runs the interactive scene, serving Prometheus metrics on port 9464 if given
+///   --metrics
+/// or with
+///   --batch camera.txt [output directory] [--png] [--software]
+/// renders a camera script offscreen and exits, or with
+///   --perf baseline.json [--frames N] [--update-baseline]
+/// times a headless run against a baseline and exits non-zero if it regressed or there is none yet, or with
+///   --stress [results.csv] [--counts 100,1000,...] [--complexity N] [--distribution grid|random|clustered]
+///            [--animated F] [--occluders F] [--no-occlusion] [--frames N] [--seed N]
+/// sweeps generated scenes over the object counts and writes frame time against N, or with
+///   --selftest
+/// checks the batched and fast math paths against the scalar ones, serialization, the software
+/// rasterizer, the buffer allocator and the exported frame time buckets, without opening a window
+/// </summary>
+int main(int argc, char* argv[])
 {
+	if (argc >= 2 && std::string(argv[1]) == "--selftest")
+	{
+		const bool mathPassed = gpp::MathSelfTest::run(std::cout);
+		const bool enginePassed = SelfTest::run(std::cout);
+		return (mathPassed && enginePassed) ? 0 : 1;
+	}
+
 	Game& game = Game();
-	game.run();
+
+	if (argc >= 3 && std::string(argv[1]) == "--batch")
+	{
+		std::string outputDirectory{ "batch" };
+		FrameCapture::Format format = FrameCapture::RAW;
+		bool software = false;
+
+		for (int i = 3; i < argc; i++)
+		{
+			if (std::string(argv[i]) == "--png") format = FrameCapture::PNG;
+			else if (std::string(argv[i]) == "--software") software = true;
+			else outputDirectory = argv[i];
+		}
+
+		return game.runBatch(argv[2], outputDirectory, format, software) ? 0 : 1;
+	}
+
+	if (argc >= 3 && std::string(argv[1]) == "--perf")
+	{
+		unsigned frames = 600;
+		bool updateBaseline = false;
+
+		for (int i = 3; i < argc; i++)
+		{
+			if (std::string(argv[i]) == "--update-baseline") updateBaseline = true;
+			else if (std::string(argv[i]) == "--frames" && i + 1 < argc) frames = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+		}
+
+		return game.runPerf(argv[2], frames, updateBaseline);
+	}
+
+	if (argc >= 2 && std::string(argv[1]) == "--stress")
+	{
+		StressParams params;
+		std::vector<unsigned> counts{ 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000 };
+		std::string output{ "stress.csv" };
+		unsigned frames = 120;
+
+		for (int i = 2; i < argc; i++)
+		{
+			const std::string option{ argv[i] };
+			const bool hasValue = i + 1 < argc;
+
+			if (option == "--counts" && hasValue)
+			{
+				counts.clear();
+				for (const char* at = argv[++i]; *at != '\0'; at++)
+				{
+					if (at == argv[i] || at[-1] == ',') counts.push_back(static_cast<unsigned>(std::max(1, atoi(at))));
+				}
+			}
+			else if (option == "--complexity" && hasValue) params.complexity = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+			else if (option == "--distribution" && hasValue)
+			{
+				if (!StressScene::parseDistribution(argv[++i], params.distribution))
+				{
+					std::cout << "Unknown distribution " << argv[i] << ", expected grid, random or clustered" << std::endl;
+					return 1;
+				}
+			}
+			else if (option == "--animated" && hasValue) params.animatedFraction = static_cast<float>(atof(argv[++i]));
+			else if (option == "--occluders" && hasValue) params.occluderFraction = static_cast<float>(atof(argv[++i]));
+			else if (option == "--no-occlusion") params.occlusionCulling = false;
+			else if (option == "--frames" && hasValue) frames = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+			else if (option == "--seed" && hasValue) params.seed = static_cast<uint32_t>(atoi(argv[++i]));
+			else output = option;
+		}
+
+		return game.runStress(params, counts, frames, output) ? 0 : 1;
+	}
+
+	game.run(argc >= 2 && std::string(argv[1]) == "--metrics");
 }
\ No newline at end of file
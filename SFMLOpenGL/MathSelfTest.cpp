@@ -0,0 +1,447 @@
+#include "MathSelfTest.h"
+#include "Matrix3Batch.h"
+#include "Trig.h"
+#include "Vector3Packet.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <math.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace gpp;
+
+namespace
+{
+	const unsigned SEED = 12345;
+	const size_t NUM_MATRICES = 1000;
+
+	// Trig sweep: evenly spaced inputs, so every quadrant and reduction step is covered
+	const float SINCOS_RANGE = 8192.0f;
+	const size_t SINCOS_SAMPLES = 1 << 22;
+	const size_t ACOS_SAMPLES = 1 << 20;
+	const double MAX_ULP = 2.0; // bounds documented in Trig.h
+	const double MAX_ABSOLUTE = 1e-7;
+	const double ULP_THRESHOLD = 1e-3; // ulp bound of sincos only applies above this magnitude
+
+	const size_t NUM_PACKETS = 257; // Vector3x8 packets; odd, so the AVX-512 pairing has a leftover
+
+	const size_t NUM_ROUND_TRIPS = 100000; // vectors and matrices of random bit patterns
+
+	/// <summary>
+	/// Bitwise equality, so -0 and 0 differ and NaNs with the same bits match
+	/// </summary>
+	bool identical(const float t_left, const float t_right)
+	{
+		return std::memcmp(&t_left, &t_right, sizeof(float)) == 0;
+	}
+
+	bool identical(const Vector3& t_left, const Vector3& t_right)
+	{
+		return identical(t_left.x, t_right.x) && identical(t_left.y, t_right.y) && identical(t_left.z, t_right.z);
+	}
+
+	/// <summary>
+	/// Every packet operation, per packet and in bulk, against Vector3 lane by lane
+	/// </summary>
+	/// <returns>lanes that differ in any operation</returns>
+	template<typename PACKET>
+	size_t comparePackets(const std::vector<Vector3>& t_left, const std::vector<Vector3>& t_right)
+	{
+		const size_t width = PACKET::WIDTH;
+		const size_t count = t_left.size() / width;
+
+		std::vector<PACKET> left(count), right(count);
+		for (size_t p = 0; p < count; p++)
+		{
+			left[p] = PACKET::load(&t_left[p * width]);
+			right[p] = PACKET::load(&t_right[p * width]);
+		}
+
+		std::vector<float> dots(count * width);
+		std::vector<PACKET> crosses(count), units(count), projections(count), rejections(count);
+		PACKET::dot(left.data(), right.data(), dots.data(), count);
+		PACKET::crossProduct(left.data(), right.data(), crosses.data(), count);
+		PACKET::unit(left.data(), units.data(), count);
+		PACKET::projection(left.data(), right.data(), projections.data(), count);
+		PACKET::rejection(left.data(), right.data(), rejections.data(), count);
+
+		size_t failures = 0;
+
+		for (size_t p = 0; p < count; p++)
+		{
+			float dot[PACKET::WIDTH];
+			left[p].dot(right[p], dot);
+
+			PACKET normalised = left[p];
+			normalised.normalise();
+
+			Vector3 lanes[7][PACKET::WIDTH];
+			left[p].crossProduct(right[p]).store(lanes[0]);
+			left[p].unit().store(lanes[1]);
+			normalised.store(lanes[2]);
+			left[p].projection(right[p]).store(lanes[3]);
+			left[p].rejection(right[p]).store(lanes[4]);
+			crosses[p].store(lanes[5]);
+			units[p].store(lanes[6]);
+
+			Vector3 bulkProjections[PACKET::WIDTH], bulkRejections[PACKET::WIDTH];
+			projections[p].store(bulkProjections);
+			rejections[p].store(bulkRejections);
+
+			for (size_t lane = 0; lane < width; lane++)
+			{
+				const Vector3 a = t_left[p * width + lane];
+				const Vector3 b = t_right[p * width + lane];
+				Vector3 scalarNormalised = a;
+				scalarNormalised.normalise();
+
+				const bool matches = identical(dot[lane], a.dot(b)) && identical(dots[p * width + lane], a.dot(b))
+					&& identical(lanes[0][lane], a.crossProduct(b)) && identical(lanes[5][lane], a.crossProduct(b))
+					&& identical(lanes[1][lane], a.unit()) && identical(lanes[6][lane], a.unit())
+					&& identical(lanes[2][lane], scalarNormalised)
+					&& identical(lanes[3][lane], a.projection(b)) && identical(bulkProjections[lane], a.projection(b))
+					&& identical(lanes[4][lane], a.rejection(b)) && identical(bulkRejections[lane], a.rejection(b));
+
+				if (!matches) failures++;
+			}
+		}
+
+		return failures;
+	}
+
+	bool identical(const Matrix3& t_left, const Matrix3& t_right)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			const Vector3 left = t_left.row(i);
+			const Vector3 right = t_right.row(i);
+			if (!identical(left.x, right.x) || !identical(left.y, right.y) || !identical(left.z, right.z)) return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Error in units of the last place of the correctly rounded result
+	/// </summary>
+	double ulpError(const float t_value, const double t_exact)
+	{
+		const float rounded = static_cast<float>(t_exact);
+		const double ulp = static_cast<double>(nextafterf(fabsf(rounded), INFINITY)) - fabsf(rounded);
+		return fabs(t_value - t_exact) / ulp;
+	}
+
+	/// <summary>
+	/// Worst errors seen by a sweep
+	/// </summary>
+	struct ErrorBound
+	{
+		double ulp = 0.0;
+		double absolute = 0.0;
+
+		void add(const float t_value, const double t_exact, const bool t_countUlp)
+		{
+			absolute = std::max(absolute, fabs(t_value - t_exact));
+			if (t_countUlp) ulp = std::max(ulp, ulpError(t_value, t_exact));
+		}
+	};
+
+	void reportBound(std::ostream& t_out, const char* t_name, const ErrorBound& t_bound, const bool t_passed)
+	{
+		t_out << (t_passed ? "PASS " : "FAIL ") << t_name << ": max " << t_bound.ulp << " ulp, max absolute " << t_bound.absolute << std::endl;
+	}
+
+	void report(std::ostream& t_out, const char* t_name, const size_t t_failures, const size_t t_checked)
+	{
+		t_out << (t_failures == 0 ? "PASS " : "FAIL ") << t_name << ": " << t_failures << " of " << t_checked << " differ" << std::endl;
+	}
+
+	/// <summary>
+	/// Any 32-bit pattern, so NaNs, infinities, subnormals and the longest decimal forms all turn up
+	/// </summary>
+	float randomBits(std::mt19937& t_random)
+	{
+		const std::uint32_t bits = static_cast<std::uint32_t>(t_random());
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	/// <summary>
+	/// Reads "[x,y,z]" back, as written by Vector3::format()
+	/// </summary>
+	bool parseVector(const char* t_text, const size_t t_length, Vector3& t_vector)
+	{
+		const char* cursor = t_text + 1;
+		const char* end = t_text + t_length;
+		float* components[3] = { &t_vector.x, &t_vector.y, &t_vector.z };
+
+		if (t_length < 2 || t_text[0] != '[') return false;
+
+		for (int i = 0; i < 3; i++)
+		{
+			std::from_chars_result result = std::from_chars(cursor, end, *components[i]);
+			if (result.ec != std::errc() || result.ptr == end || *result.ptr != (i < 2 ? ',' : ']')) return false;
+			cursor = result.ptr + 1;
+		}
+
+		return cursor == end;
+	}
+}
+
+/// <summary>
+/// Multiply, transpose and determinant must equal the scalar results bit
+/// for bit, and so must the inverse, which uses the same adjugate and
+/// reciprocal. The last matrix has a zero row and must be flagged singular.
+/// </summary>
+bool MathSelfTest::matrixBatch(std::ostream& t_out)
+{
+	std::mt19937 random(SEED);
+	std::uniform_real_distribution<float> element(-10.0f, 10.0f);
+
+	Matrix3Batch left, right;
+	std::vector<Matrix3> scalarLeft, scalarRight;
+
+	for (size_t i = 0; i < NUM_MATRICES; i++)
+	{
+		float values[18];
+		for (float& value : values) value = element(random);
+
+		if (i + 1 == NUM_MATRICES) values[6] = values[7] = values[8] = 0.0f; // singular
+
+		scalarLeft.push_back(Matrix3(values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7], values[8]));
+		scalarRight.push_back(Matrix3(values[9], values[10], values[11], values[12], values[13], values[14], values[15], values[16], values[17]));
+		left.push_back(scalarLeft.back());
+		right.push_back(scalarRight.back());
+	}
+
+	Matrix3Batch product, transposed, inverted;
+	std::vector<float> determinants(NUM_MATRICES);
+	std::vector<unsigned char> singular(NUM_MATRICES);
+
+	Matrix3Batch::multiply(left, right, product);
+	Matrix3Batch::transpose(left, transposed);
+	Matrix3Batch::determinant(left, determinants.data());
+	Matrix3Batch::inverse(left, inverted, singular.data());
+
+	size_t multiplyFailures = 0, transposeFailures = 0, determinantFailures = 0, inverseFailures = 0;
+
+	for (size_t i = 0; i < NUM_MATRICES; i++)
+	{
+		if (!identical(product.get(i), scalarLeft[i] * scalarRight[i])) multiplyFailures++;
+		if (!identical(transposed.get(i), scalarLeft[i].transpose())) transposeFailures++;
+		if (!identical(determinants[i], scalarLeft[i].determinant())) determinantFailures++;
+
+		// The scalar inverse divides by zero for the singular matrix; the batch flags it and returns null, signed zeros and all
+		const bool expectSingular = i + 1 == NUM_MATRICES;
+		const bool inverseMatches = expectSingular ? inverted.get(i) == Matrix3() : identical(inverted.get(i), scalarLeft[i].inverse());
+		if ((singular[i] != 0) != expectSingular || !inverseMatches) inverseFailures++;
+	}
+
+	report(t_out, "Matrix3Batch::multiply", multiplyFailures, NUM_MATRICES);
+	report(t_out, "Matrix3Batch::transpose", transposeFailures, NUM_MATRICES);
+	report(t_out, "Matrix3Batch::determinant", determinantFailures, NUM_MATRICES);
+	report(t_out, "Matrix3Batch::inverse", inverseFailures, NUM_MATRICES);
+
+	return multiplyFailures + transposeFailures + determinantFailures + inverseFailures == 0;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Measures the FAST sincos, scalar and array, over [-SINCOS_RANGE, SINCOS_RANGE]
+/// and the FAST acos over [-1, 1] against the double precision C runtime.
+/// Prints the worst errors, which are the figures Trig.h rounds up.
+/// </summary>
+bool MathSelfTest::trig(std::ostream& t_out)
+{
+	std::vector<float> angles(SINCOS_SAMPLES);
+	for (size_t i = 0; i < SINCOS_SAMPLES; i++)
+	{
+		angles[i] = static_cast<float>(-SINCOS_RANGE + 2.0 * SINCOS_RANGE * i / (SINCOS_SAMPLES - 1));
+	}
+
+	std::vector<float> sines(SINCOS_SAMPLES), cosines(SINCOS_SAMPLES);
+	Trig::sincos(angles.data(), sines.data(), cosines.data(), SINCOS_SAMPLES, FAST);
+
+	ErrorBound sincosBound, arrayBound;
+
+	for (size_t i = 0; i < SINCOS_SAMPLES; i++)
+	{
+		float sine, cosine;
+		Trig::sincos(angles[i], sine, cosine, FAST);
+
+		const double exactSine = sin(static_cast<double>(angles[i]));
+		const double exactCosine = cos(static_cast<double>(angles[i]));
+		sincosBound.add(sine, exactSine, fabs(exactSine) > ULP_THRESHOLD);
+		sincosBound.add(cosine, exactCosine, fabs(exactCosine) > ULP_THRESHOLD);
+
+		arrayBound.add(sines[i], exactSine, fabs(exactSine) > ULP_THRESHOLD);
+		arrayBound.add(cosines[i], exactCosine, fabs(exactCosine) > ULP_THRESHOLD);
+	}
+
+	ErrorBound acosBound;
+	for (size_t i = 0; i < ACOS_SAMPLES; i++)
+	{
+		const float x = static_cast<float>(-1.0 + 2.0 * i / (ACOS_SAMPLES - 1));
+		acosBound.add(Trig::acos(x, FAST), acos(static_cast<double>(x)), true);
+	}
+
+	const bool sincosPassed = sincosBound.ulp <= MAX_ULP && sincosBound.absolute < MAX_ABSOLUTE;
+	const bool arrayPassed = arrayBound.ulp <= MAX_ULP && arrayBound.absolute < MAX_ABSOLUTE;
+	const bool acosPassed = acosBound.ulp <= MAX_ULP;
+
+	reportBound(t_out, "Trig::sincos FAST", sincosBound, sincosPassed);
+	reportBound(t_out, "Trig::sincos FAST array", arrayBound, arrayPassed);
+	reportBound(t_out, "Trig::acos FAST", acosBound, acosPassed);
+
+	return sincosPassed && arrayPassed && acosPassed;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Every packet operation must give the Vector3 result bit for bit, at each
+/// dispatch level from scalar up to the best the CPU has. Zero vectors are
+/// mixed in so the divide-by-zero guards are exercised.
+/// </summary>
+bool MathSelfTest::vectorPacket(std::ostream& t_out)
+{
+	std::mt19937 random(SEED);
+	std::uniform_real_distribution<float> component(-100.0f, 100.0f);
+
+	const size_t numVectors = NUM_PACKETS * Vector3x8::WIDTH;
+	std::vector<Vector3> left(numVectors), right(numVectors);
+
+	for (size_t i = 0; i < numVectors; i++)
+	{
+		left[i] = (i % 17 == 0) ? Vector3(0.0f, 0.0f, 0.0f) : Vector3(component(random), component(random), component(random));
+		right[i] = (i % 13 == 0) ? Vector3(0.0f, 0.0f, 0.0f) : Vector3(component(random), component(random), component(random));
+	}
+
+	const SimdLevel best = Simd::detect();
+	bool passed = true;
+
+	for (int level = SIMD_SCALAR; level <= best; level++)
+	{
+		Simd::setLevel(static_cast<SimdLevel>(level));
+
+		const size_t failures4 = comparePackets<Vector3x4>(left, right);
+		const size_t failures8 = comparePackets<Vector3x8>(left, right);
+
+		const std::string name4 = std::string("Vector3x4 ") + Simd::name(Simd::active());
+		const std::string name8 = std::string("Vector3x8 ") + Simd::name(Simd::active());
+		report(t_out, name4.c_str(), failures4, numVectors);
+		report(t_out, name8.c_str(), failures8, numVectors);
+
+		passed = passed && failures4 == 0 && failures8 == 0;
+	}
+
+	Simd::setLevel(best);
+
+	return passed;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// serialize() then deserialize(), one at a time and as arrays, must give
+/// back the same bits, NaN payloads included, and the bytes must be
+/// little-endian. format() must fit in MAX_FORMAT_LENGTH for the longest
+/// floats there are, and a vector's text must read back to the same floats.
+/// </summary>
+bool MathSelfTest::serialization(std::ostream& t_out)
+{
+	std::mt19937 random(SEED);
+
+	// Longest decimal forms first, then random bit patterns
+	const float extremes[] = { -1.00000075e-36f, -FLT_MAX, -FLT_MIN, -FLT_TRUE_MIN, -3.40282326e+38f, -0.0f, -INFINITY, NAN }; // the first needs all 15 chars a float can take
+	const size_t numExtremes = sizeof(extremes) / sizeof(extremes[0]);
+
+	std::vector<Vector3> vectors(NUM_ROUND_TRIPS);
+	std::vector<Matrix3> matrices(NUM_ROUND_TRIPS);
+
+	for (size_t i = 0; i < NUM_ROUND_TRIPS; i++)
+	{
+		float values[9];
+		for (size_t j = 0; j < 9; j++)
+		{
+			values[j] = (i == 0) ? extremes[0] : (i < numExtremes) ? extremes[(i + j) % numExtremes] : randomBits(random);
+		}
+
+		vectors[i] = Vector3(values[0], values[1], values[2]);
+		matrices[i] = Matrix3(values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7], values[8]);
+	}
+
+	std::vector<unsigned char> vectorBytes(NUM_ROUND_TRIPS * Vector3::SERIALIZED_SIZE);
+	std::vector<unsigned char> matrixBytes(NUM_ROUND_TRIPS * Matrix3::SERIALIZED_SIZE);
+	std::vector<Vector3> vectorsBack(NUM_ROUND_TRIPS);
+	std::vector<Matrix3> matricesBack(NUM_ROUND_TRIPS);
+
+	Vector3::serializeArray(vectors.data(), NUM_ROUND_TRIPS, vectorBytes.data());
+	Vector3::deserializeArray(vectorBytes.data(), NUM_ROUND_TRIPS, vectorsBack.data());
+	Matrix3::serializeArray(matrices.data(), NUM_ROUND_TRIPS, matrixBytes.data());
+	Matrix3::deserializeArray(matrixBytes.data(), NUM_ROUND_TRIPS, matricesBack.data());
+
+	size_t vectorFailures = 0, matrixFailures = 0, vectorFormatFailures = 0, matrixFormatFailures = 0;
+	size_t longestVector = 0, longestMatrix = 0;
+
+	for (size_t i = 0; i < NUM_ROUND_TRIPS; i++)
+	{
+		unsigned char single[Matrix3::SERIALIZED_SIZE];
+
+		vectors[i].serialize(single);
+		if (!identical(vectorsBack[i], vectors[i]) || !identical(Vector3::deserialize(single), vectors[i])) vectorFailures++;
+
+		matrices[i].serialize(single);
+		if (!identical(matricesBack[i], matrices[i]) || !identical(Matrix3::deserialize(single), matrices[i])) matrixFailures++;
+
+		// Exactly MAX_FORMAT_LENGTH, so text that only fits a bigger buffer fails
+		char text[Matrix3::MAX_FORMAT_LENGTH];
+
+		const size_t vectorLength = vectors[i].format(text, Vector3::MAX_FORMAT_LENGTH);
+		Vector3 parsed;
+		const bool hasNaN = vectors[i].x != vectors[i].x || vectors[i].y != vectors[i].y || vectors[i].z != vectors[i].z;
+		if (vectorLength == 0 || (!hasNaN && (!parseVector(text, vectorLength, parsed) || !identical(parsed, vectors[i]))))
+		{
+			vectorFormatFailures++;
+		}
+		longestVector = std::max(longestVector, vectorLength);
+
+		const size_t matrixLength = matrices[i].format(text, Matrix3::MAX_FORMAT_LENGTH);
+		if (matrixLength == 0) matrixFormatFailures++;
+		longestMatrix = std::max(longestMatrix, matrixLength);
+	}
+
+	// 1.0f is 0x3F800000, so its bytes must come out low first
+	unsigned char one[Vector3::SERIALIZED_SIZE];
+	Vector3(1.0f, 1.0f, 1.0f).serialize(one);
+	if (one[0] != 0x00 || one[1] != 0x00 || one[2] != 0x80 || one[3] != 0x3F) vectorFailures++;
+
+	report(t_out, "Vector3 serialize round trip", vectorFailures, NUM_ROUND_TRIPS);
+	report(t_out, "Matrix3 serialize round trip", matrixFailures, NUM_ROUND_TRIPS);
+	report(t_out, "Vector3::format", vectorFormatFailures, NUM_ROUND_TRIPS);
+	report(t_out, "Matrix3::format", matrixFormatFailures, NUM_ROUND_TRIPS);
+	t_out << "     longest format: " << longestVector << " of " << Vector3::MAX_FORMAT_LENGTH - 1 << " chars for a vector, "
+		<< longestMatrix << " of " << Matrix3::MAX_FORMAT_LENGTH - 1 << " for a matrix" << std::endl;
+
+	return vectorFailures + matrixFailures + vectorFormatFailures + matrixFormatFailures == 0;
+}
+
+/////////////////////////////////////////////////////////
+
+bool MathSelfTest::run(std::ostream& t_out)
+{
+	bool passed = true;
+
+	passed = matrixBatch(t_out) && passed;
+	passed = trig(t_out) && passed;
+	passed = vectorPacket(t_out) && passed;
+	passed = serialization(t_out) && passed;
+
+	return passed;
+}
@@ -0,0 +1,41 @@
+#ifndef MY_MATH_SELF_TEST
+#define MY_MATH_SELF_TEST
+#include <ostream>
+
+namespace gpp
+{
+	/// <summary>
+	/// Checks the batched and fast math paths against the scalar ones they
+	/// stand in for, and the serialized and text forms, on fixed pseudo-random
+	/// inputs. Run with --selftest.
+	/// </summary>
+	namespace MathSelfTest
+	{
+		/// <summary>
+		/// @brief Matrix3Batch against Matrix3 on random matrices plus a singular one
+		/// </summary>
+		bool matrixBatch(std::ostream& t_out);
+
+		/// <summary>
+		/// @brief Sweeps the FAST trig paths against double precision and checks the documented error bounds
+		/// </summary>
+		bool trig(std::ostream& t_out);
+
+		/// <summary>
+		/// @brief Vector3x4 and Vector3x8 against Vector3 at every SIMD level the CPU supports
+		/// </summary>
+		bool vectorPacket(std::ostream& t_out);
+
+		/// <summary>
+		/// @brief Vector3 and Matrix3 serialize/deserialize round trips and format() lengths on worst-case floats
+		/// </summary>
+		bool serialization(std::ostream& t_out);
+
+		/// <summary>
+		/// @brief Runs every check, printing one line each
+		/// </summary>
+		/// <returns>true if all passed</returns>
+		bool run(std::ostream& t_out);
+	}
+}
+#endif // !MY_MATH_SELF_TEST
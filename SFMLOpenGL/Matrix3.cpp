@@ -1,4 +1,5 @@
 #include "Matrix3.h"
+#include "Serialization.h"
 #include <math.h>
 
 using namespace gpp;
@@ -68,6 +69,100 @@ std::string Matrix3::toString() const
 	return output;
 }
 
+/// <summary>
+/// Formats a matrix in toString()'s row layout into a caller-supplied buffer,
+/// without allocating. Elements use the shortest form that reads back to the
+/// same float rather than toString()'s six fixed decimals.
+/// </summary>
+/// <param name="t_buffer">destination, MAX_FORMAT_LENGTH always suffices</param>
+/// <param name="t_size">size of t_buffer in chars</param>
+/// <returns>characters written excluding the null, or 0 if t_buffer is too small</returns>
+size_t Matrix3::format(char* t_buffer, const size_t t_size) const
+{
+	if (t_size == 0) return 0;
+
+	char* cursor = t_buffer;
+	char* end = t_buffer + t_size - 1; // leave room for the null
+	bool fits = Text::append(cursor, end, '[');
+
+	for (int i = 0; i < NUM_ROWS && fits; i++) // for all rows
+	{
+		for (int j = 0; j < NUM_COLS && fits; j++) // for all columns
+		{
+			fits = Text::append(cursor, end, m[i][j]);
+			if (fits && j < NUM_COLS - 1) fits = Text::append(cursor, end, ", "); // if not last column, add comma
+		}
+		if (fits) fits = Text::append(cursor, end, (i < NUM_ROWS - 1) ? "|\n|" : "]"); // if not last row, add | and new line, otherwise add ]
+	}
+
+	*cursor = '\0';
+
+	return fits ? static_cast<size_t>(cursor - t_buffer) : 0;
+}
+
+/// <summary>
+/// Writes the matrix as SERIALIZED_SIZE little-endian bytes, row by row
+/// </summary>
+/// <param name="t_dst">destination, at least SERIALIZED_SIZE bytes</param>
+void Matrix3::serialize(unsigned char* t_dst) const
+{
+	for (int i = 0; i < NUM_ROWS; i++) // for all rows
+	{
+		for (int j = 0; j < NUM_COLS; j++) // for all columns
+		{
+			t_dst = Binary::writeFloat(t_dst, m[i][j]);
+		}
+	}
+}
+
+/// <summary>
+/// Reads a matrix written by serialize()
+/// </summary>
+/// <param name="t_src">source, at least SERIALIZED_SIZE bytes</param>
+/// <returns>the deserialized matrix</returns>
+Matrix3 Matrix3::deserialize(const unsigned char* t_src)
+{
+	Matrix3 result;
+
+	for (int i = 0; i < NUM_ROWS; i++) // for all rows
+	{
+		for (int j = 0; j < NUM_COLS; j++) // for all columns
+		{
+			t_src = Binary::readFloat(t_src, result.m[i][j]);
+		}
+	}
+
+	return result;
+}
+
+/// <summary>
+/// Serializes matrices back to back
+/// </summary>
+/// <param name="t_matrices">matrices to write</param>
+/// <param name="t_count">number of matrices</param>
+/// <param name="t_dst">destination, at least t_count * SERIALIZED_SIZE bytes</param>
+void Matrix3::serializeArray(const Matrix3* t_matrices, const size_t t_count, unsigned char* t_dst)
+{
+	for (size_t i = 0; i < t_count; i++)
+	{
+		t_matrices[i].serialize(t_dst + i * SERIALIZED_SIZE);
+	}
+}
+
+/// <summary>
+/// Reads matrices written by serializeArray()
+/// </summary>
+/// <param name="t_src">source, at least t_count * SERIALIZED_SIZE bytes</param>
+/// <param name="t_count">number of matrices</param>
+/// <param name="t_matrices">destination array</param>
+void Matrix3::deserializeArray(const unsigned char* t_src, const size_t t_count, Matrix3* t_matrices)
+{
+	for (size_t i = 0; i < t_count; i++)
+	{
+		t_matrices[i] = deserialize(t_src + i * SERIALIZED_SIZE);
+	}
+}
+
 /// <summary>
 /// Checks for equality of two 3x3 matrices
 /// </summary>
@@ -356,11 +451,15 @@ Matrix3 Matrix3::scale(const float t_scalingfactor)
 /// Determines the matrix for counter-clockwise rotation about the Z-axis
 /// </summary>
 /// <param name="t_angleRadians">Angle of rotation</param>
+/// <param name="t_accuracy">EXACT or FAST trig</param>
 /// <returns>Rotation matrix</returns>
-Matrix3 Matrix3::rotationZ(const float t_angleRadians)
+Matrix3 Matrix3::rotationZ(const float t_angleRadians, const TrigAccuracy t_accuracy)
 {
-	Matrix3 rotation = { cos(t_angleRadians), -sin(t_angleRadians), 0.0f,
-							sin(t_angleRadians), cos(t_angleRadians), 0.0f,
+	float sine, cosine;
+	Trig::sincos(t_angleRadians, sine, cosine, t_accuracy); // one evaluation of each
+
+	Matrix3 rotation = { cosine, -sine, 0.0f,
+							sine, cosine, 0.0f,
 							0.0f, 0.0f, 1.0f };
 
 	return rotation;
@@ -370,13 +469,16 @@ Matrix3 Matrix3::rotationZ(const float t_angleRadians)
 /// Determines the matrix for counter-clockwise rotation about the Y-axis
 /// </summary>
 /// <param name="t_angleRadians">Angle of rotation</param>
+/// <param name="t_accuracy">EXACT or FAST trig</param>
 /// <returns>Rotation matrix</returns>
-Matrix3 Matrix3::rotationY(const float t_angleRadians)
+Matrix3 Matrix3::rotationY(const float t_angleRadians, const TrigAccuracy t_accuracy)
 {
+	float sine, cosine;
+	Trig::sincos(t_angleRadians, sine, cosine, t_accuracy); // one evaluation of each
 
-	Matrix3 rotation = { cos(t_angleRadians), 0.0f, sin(t_angleRadians),
+	Matrix3 rotation = { cosine, 0.0f, sine,
 							0.0f, 1.0f, 0.0f,
-							-sin(t_angleRadians), 0.0f, cos(t_angleRadians) };
+							-sine, 0.0f, cosine };
 
 	return rotation;
 }
@@ -386,13 +488,16 @@ Matrix3 Matrix3::rotationY(const float t_angleRadians)
 /// Determines the matrix for counter-clockwise rotation about the X-axis
 /// </summary>
 /// <param name="t_angleRadians">Angle of rotation</param>
+/// <param name="t_accuracy">EXACT or FAST trig</param>
 /// <returns>Rotation matrix</returns>
-Matrix3 Matrix3::rotationX(const float t_angleRadians)
+Matrix3 Matrix3::rotationX(const float t_angleRadians, const TrigAccuracy t_accuracy)
 {
+	float sine, cosine;
+	Trig::sincos(t_angleRadians, sine, cosine, t_accuracy); // one evaluation of each
 
 	Matrix3 rotation = { 1.0f, 0.0f, 0.0f,
-							0.0f, cos(t_angleRadians), -sin(t_angleRadians),
-							0.0f, sin(t_angleRadians), cos(t_angleRadians) };
+							0.0f, cosine, -sine,
+							0.0f, sine, cosine };
 
 	return rotation;
 }
\ No newline at end of file
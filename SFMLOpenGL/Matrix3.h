@@ -1,6 +1,7 @@
 #ifndef MY_MATRIX
 #define MY_MATRIX
 #include "Vector3.h"
+#include "Trig.h"
 
 namespace gpp
 {
@@ -17,6 +18,15 @@ namespace gpp
 
 		std::string toString()const;
 
+		static const size_t MAX_FORMAT_LENGTH = 192; // buffer size that fits any matrix, including the null
+		static const size_t SERIALIZED_SIZE = 36; // bytes per matrix, row-major
+
+		size_t format(char* t_buffer, const size_t t_size) const; // toString()'s rows, shortest round-trip digits, no allocation
+		void serialize(unsigned char* t_dst) const; // little-endian
+		static Matrix3 deserialize(const unsigned char* t_src);
+		static void serializeArray(const Matrix3* t_matrices, const size_t t_count, unsigned char* t_dst);
+		static void deserializeArray(const unsigned char* t_src, const size_t t_count, Matrix3* t_matrices);
+
 		bool operator ==(const Matrix3 other)const;
 		bool operator !=(const Matrix3 other)const;
 
@@ -35,9 +45,9 @@ namespace gpp
 		Vector3 row(const int t_row)const; // 0 is first row then 1,2
 		Vector3 column(const int t_column) const;
 
-		static Matrix3 rotationZ(const float t_angleRadians); // counterclockwise
-		static Matrix3 rotationY(const float t_angleRadians);
-		static Matrix3 rotationX(const float t_angleRadians);// {1,-3,2} = Matrix3::rotationX(PI/2)*{1,2,3}
+		static Matrix3 rotationZ(const float t_angleRadians, const TrigAccuracy t_accuracy = EXACT); // counterclockwise
+		static Matrix3 rotationY(const float t_angleRadians, const TrigAccuracy t_accuracy = EXACT);
+		static Matrix3 rotationX(const float t_angleRadians, const TrigAccuracy t_accuracy = EXACT);// {1,-3,2} = Matrix3::rotationX(PI/2)*{1,2,3}
 
 		static Matrix3 translation(const Vector3 t_displacement); // 2d translation make sure z=1
 		static Matrix3 scale(const float t_scalingfactor);
@@ -0,0 +1,208 @@
+#include "Matrix3Batch.h"
+#include <math.h>
+
+using namespace gpp;
+
+/// <summary>
+/// Default (empty) constructor for Matrix3Batch
+/// </summary>
+Matrix3Batch::Matrix3Batch() :
+	m_size{ 0 }
+{
+}
+
+/// <summary>
+/// Constructor for a batch of t_size null matrices
+/// </summary>
+/// <param name="t_size">number of matrices</param>
+Matrix3Batch::Matrix3Batch(const size_t t_size) :
+	m_size{ 0 }
+{
+	resize(t_size);
+}
+
+/// <summary>
+/// Resizes the batch; new matrices are null
+/// </summary>
+/// <param name="t_size">number of matrices</param>
+void Matrix3Batch::resize(const size_t t_size)
+{
+	for (int i = 0; i < NUM_ROWS; i++) // for all rows
+	{
+		for (int j = 0; j < NUM_COLS; j++) // for all columns
+		{
+			m_elements[i][j].resize(t_size, 0.0f);
+		}
+	}
+
+	m_size = t_size;
+}
+
+/// <summary>
+/// Removes every matrix, keeping the allocated storage
+/// </summary>
+void Matrix3Batch::clear()
+{
+	resize(0);
+}
+
+/// <summary>
+/// Appends a matrix to the end of the batch
+/// </summary>
+/// <param name="t_matrix">matrix to append</param>
+void Matrix3Batch::push_back(const Matrix3 t_matrix)
+{
+	resize(m_size + 1);
+	set(m_size - 1, t_matrix);
+}
+
+/// <summary>
+/// Scatters a matrix into the batch
+/// </summary>
+/// <param name="t_index">matrix index</param>
+/// <param name="t_matrix">matrix to store</param>
+void Matrix3Batch::set(const size_t t_index, const Matrix3 t_matrix)
+{
+	for (int i = 0; i < NUM_ROWS; i++) // for all rows
+	{
+		Vector3 row = t_matrix.row(i);
+		m_elements[i][0][t_index] = row.x;
+		m_elements[i][1][t_index] = row.y;
+		m_elements[i][2][t_index] = row.z;
+	}
+}
+
+/// <summary>
+/// Gathers a matrix out of the batch
+/// </summary>
+/// <param name="t_index">matrix index</param>
+/// <returns>the matrix at t_index</returns>
+Matrix3 Matrix3Batch::get(const size_t t_index) const
+{
+	return Matrix3(
+		m_elements[0][0][t_index], m_elements[0][1][t_index], m_elements[0][2][t_index],
+		m_elements[1][0][t_index], m_elements[1][1][t_index], m_elements[1][2][t_index],
+		m_elements[2][0][t_index], m_elements[2][1][t_index], m_elements[2][2][t_index]);
+}
+
+/// <summary>
+/// Multiplies each matrix in t_left by the matrix at the same index in t_right
+/// </summary>
+/// <param name="t_left">left operands</param>
+/// <param name="t_right">right operands, same size as t_left</param>
+/// <param name="t_result">products, resized to match; must not alias either operand</param>
+void Matrix3Batch::multiply(const Matrix3Batch& t_left, const Matrix3Batch& t_right, Matrix3Batch& t_result)
+{
+	const size_t count = t_left.m_size;
+	t_result.resize(count);
+
+	for (int i = 0; i < NUM_ROWS; i++) // for each row
+	{
+		const float* a0 = t_left.element(i, 0);
+		const float* a1 = t_left.element(i, 1);
+		const float* a2 = t_left.element(i, 2);
+
+		for (int j = 0; j < NUM_COLS; j++) // for each column
+		{
+			const float* b0 = t_right.element(0, j);
+			const float* b1 = t_right.element(1, j);
+			const float* b2 = t_right.element(2, j);
+			float* out = t_result.element(i, j);
+
+			for (size_t k = 0; k < count; k++) // for each matrix
+			{
+				out[k] = a0[k] * b0[k] + a1[k] * b1[k] + a2[k] * b2[k]; // row i . column j
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Transposes every matrix in the batch
+/// </summary>
+/// <param name="t_matrices">matrices to transpose</param>
+/// <param name="t_result">transposed matrices, resized to match; must not alias t_matrices</param>
+void Matrix3Batch::transpose(const Matrix3Batch& t_matrices, Matrix3Batch& t_result)
+{
+	const size_t count = t_matrices.m_size;
+	t_result.resize(count);
+
+	for (int i = 0; i < NUM_ROWS; i++)
+	{
+		for (int j = 0; j < NUM_COLS; j++)
+		{
+			const float* in = t_matrices.element(i, j);
+			float* out = t_result.element(j, i);
+
+			for (size_t k = 0; k < count; k++)
+			{
+				out[k] = in[k]; // transpose m rows into result columns
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Calculates the determinant of every matrix in the batch
+/// </summary>
+/// <param name="t_matrices">input matrices</param>
+/// <param name="t_result">array of at least size() floats</param>
+void Matrix3Batch::determinant(const Matrix3Batch& t_matrices, float* t_result)
+{
+	const size_t count = t_matrices.m_size;
+	const float* a = t_matrices.element(0, 0), * b = t_matrices.element(0, 1), * c = t_matrices.element(0, 2),
+		* d = t_matrices.element(1, 0), * e = t_matrices.element(1, 1), * f = t_matrices.element(1, 2),
+		* g = t_matrices.element(2, 0), * h = t_matrices.element(2, 1), * i = t_matrices.element(2, 2);
+
+	for (size_t k = 0; k < count; k++)
+	{
+		t_result[k] = (a[k] * e[k] * i[k]) + (b[k] * f[k] * g[k]) + (c[k] * d[k] * h[k])
+			- (c[k] * e[k] * g[k]) - (b[k] * d[k] * i[k]) - (a[k] * f[k] * h[k]);
+	}
+}
+
+/// <summary>
+/// Inverts every matrix in the batch as adjugate / determinant.
+/// Matrices whose |determinant| is at most t_epsilon are flagged in
+/// t_singular and their result is the null matrix.
+/// </summary>
+/// <param name="t_matrices">matrices to invert</param>
+/// <param name="t_result">inverses, resized to match; must not alias t_matrices</param>
+/// <param name="t_singular">array of at least size() flags, 1 where the matrix is singular; may be NULL</param>
+/// <param name="t_epsilon">determinant magnitude treated as singular</param>
+void Matrix3Batch::inverse(const Matrix3Batch& t_matrices, Matrix3Batch& t_result, unsigned char* t_singular,
+	const float t_epsilon)
+{
+	const size_t count = t_matrices.m_size;
+	t_result.resize(count);
+
+	const float* m00 = t_matrices.element(0, 0), * m01 = t_matrices.element(0, 1), * m02 = t_matrices.element(0, 2),
+		* m10 = t_matrices.element(1, 0), * m11 = t_matrices.element(1, 1), * m12 = t_matrices.element(1, 2),
+		* m20 = t_matrices.element(2, 0), * m21 = t_matrices.element(2, 1), * m22 = t_matrices.element(2, 2);
+
+	float* r00 = t_result.element(0, 0), * r01 = t_result.element(0, 1), * r02 = t_result.element(0, 2),
+		* r10 = t_result.element(1, 0), * r11 = t_result.element(1, 1), * r12 = t_result.element(1, 2),
+		* r20 = t_result.element(2, 0), * r21 = t_result.element(2, 1), * r22 = t_result.element(2, 2);
+
+	for (size_t k = 0; k < count; k++)
+	{
+		float determinant = (m00[k] * m11[k] * m22[k]) + (m01[k] * m12[k] * m20[k]) + (m02[k] * m10[k] * m21[k])
+			- (m02[k] * m11[k] * m20[k]) - (m01[k] * m10[k] * m22[k]) - (m00[k] * m12[k] * m21[k]);
+
+		bool singular = fabsf(determinant) <= t_epsilon;
+		float scale = singular ? 0.0f : 1.0f / determinant; // branch-free select keeps the loop vectorisable
+
+		if (t_singular) t_singular[k] = singular ? 1 : 0;
+
+		// determine adjugate of input matrix, scaled by 1/determinant
+		r00[k] = (m22[k] * m11[k] - m21[k] * m12[k]) * scale;
+		r01[k] = (m21[k] * m02[k] - m22[k] * m01[k]) * scale;
+		r02[k] = (m12[k] * m01[k] - m11[k] * m02[k]) * scale;
+		r10[k] = (m20[k] * m12[k] - m22[k] * m10[k]) * scale;
+		r11[k] = (m22[k] * m00[k] - m20[k] * m02[k]) * scale;
+		r12[k] = (m10[k] * m02[k] - m12[k] * m00[k]) * scale;
+		r20[k] = (m21[k] * m10[k] - m20[k] * m11[k]) * scale;
+		r21[k] = (m20[k] * m01[k] - m21[k] * m00[k]) * scale;
+		r22[k] = (m11[k] * m00[k] - m10[k] * m01[k]) * scale;
+	}
+}
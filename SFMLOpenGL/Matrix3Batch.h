@@ -0,0 +1,43 @@
+#ifndef MY_MATRIX_BATCH
+#define MY_MATRIX_BATCH
+#include "Matrix3.h"
+#include <vector>
+
+namespace gpp
+{
+	/// <summary>
+	/// Structure-of-arrays container of 3x3 matrices. Element (i, j) of every
+	/// matrix is stored contiguously, so batch operations are simple loops the
+	/// compiler can vectorise. Results match the scalar Matrix3 operations.
+	/// </summary>
+	class Matrix3Batch
+	{
+	public:
+		Matrix3Batch();
+		explicit Matrix3Batch(const size_t t_size);
+
+		size_t size() const { return m_size; }
+		void resize(const size_t t_size);
+		void clear();
+
+		void push_back(const Matrix3 t_matrix);
+		void set(const size_t t_index, const Matrix3 t_matrix);
+		Matrix3 get(const size_t t_index) const;
+
+		float* element(const int t_row, const int t_column) { return m_elements[t_row][t_column].data(); }
+		const float* element(const int t_row, const int t_column) const { return m_elements[t_row][t_column].data(); }
+
+		static void multiply(const Matrix3Batch& t_left, const Matrix3Batch& t_right, Matrix3Batch& t_result);
+		static void transpose(const Matrix3Batch& t_matrices, Matrix3Batch& t_result);
+		static void determinant(const Matrix3Batch& t_matrices, float* t_result);
+		static void inverse(const Matrix3Batch& t_matrices, Matrix3Batch& t_result, unsigned char* t_singular,
+			const float t_epsilon = 1e-12f);
+
+	private:
+		static const int NUM_ROWS = 3;
+		static const int NUM_COLS = 3;
+		std::vector<float> m_elements[NUM_ROWS][NUM_COLS];
+		size_t m_size;
+	};
+}
+#endif // !MY_MATRIX_BATCH
@@ -0,0 +1,134 @@
+#include <Mesh.h>
+#include <GeometryPool.h>
+
+#include <cstddef>
+
+const VertexAttribute Mesh::DEFAULT_LAYOUT[2] = {
+	{ POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, coordinate) },
+	{ COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, offsetof(Vertex, color) }
+};
+
+/////////////////////////////////////////////////////////
+
+GLsizei Mesh::indexSize(GLenum t_indexType)
+{
+	return (t_indexType == GL_UNSIGNED_INT) ? 4 : (t_indexType == GL_UNSIGNED_SHORT) ? 2 : 1;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Uploads vertex and index data and records the attribute layout in a new VAO
+/// </summary>
+/// <param name="t_resources">allocates and later releases the GL objects</param>
+/// <param name="t_state">state cache of the current context</param>
+/// <param name="t_vertices">vertex data</param>
+/// <param name="t_numVertices">number of vertices</param>
+/// <param name="t_indices">index data</param>
+/// <param name="t_numIndices">number of indices</param>
+/// <param name="t_indexType">GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT</param>
+/// <param name="t_layout">attributes to enable</param>
+/// <param name="t_numAttributes">number of entries in t_layout</param>
+void Mesh::load(GLResources& t_resources, GLStateCache& t_state, const Vertex* t_vertices, GLsizei t_numVertices,
+	const void* t_indices, GLsizei t_numIndices, GLenum t_indexType,
+	const VertexAttribute* t_layout, int t_numAttributes)
+{
+	m_numIndices = t_numIndices;
+	m_indexType = t_indexType;
+
+	m_vao = t_resources.createVertexArray();
+	t_state.bindVertexArray(m_vao.name());
+
+	m_vbo = t_resources.createBuffer();
+	t_resources.bufferData(m_vbo.handle(), GL_ARRAY_BUFFER, sizeof(Vertex) * t_numVertices, t_vertices, GL_DYNAMIC_DRAW);
+
+	// The element buffer binding is VAO state, so leave it bound
+	m_ibo = t_resources.createBuffer();
+	t_resources.bufferData(m_ibo.handle(), GL_ELEMENT_ARRAY_BUFFER, indexSize(t_indexType) * t_numIndices, t_indices, GL_STATIC_DRAW);
+
+	// Set pointers for each parameter
+	// https://www.opengl.org/sdk/docs/man4/html/glVertexAttribPointer.xhtml
+	for (int i = 0; i < t_numAttributes; i++)
+	{
+		const VertexAttribute& attribute = t_layout[i];
+		glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized,
+			sizeof(Vertex), (char*)NULL + attribute.offset);
+		glEnableVertexAttribArray(attribute.location);
+	}
+
+	t_state.bindVertexArray(0);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Copies vertex and index data into a shared pool instead of buffers of its own.
+/// The pool's layout applies.
+/// </summary>
+/// <param name="t_pool">initialized pool that outlives the mesh's use of it</param>
+void Mesh::load(GeometryPool& t_pool, GLResources& t_resources, GLStateCache& t_state, const Vertex* t_vertices, GLsizei t_numVertices,
+	const void* t_indices, GLsizei t_numIndices, GLenum t_indexType)
+{
+	m_numIndices = t_numIndices;
+	m_indexType = t_indexType;
+
+	m_poolId = t_pool.allocate(t_resources, t_state, t_vertices, t_numVertices, t_indices, t_numIndices, t_indexType);
+	m_pool = (m_poolId != GeometryPool::INVALID) ? &t_pool : nullptr;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Re-uploads vertex data modified on the CPU. Does not touch the VAO.
+/// </summary>
+void Mesh::updateVertices(GLStateCache& t_state, const Vertex* t_vertices, GLsizei t_numVertices)
+{
+	if (m_pool)
+	{
+		m_pool->updateVertices(t_state, m_poolId, t_vertices, t_numVertices);
+		return;
+	}
+
+	t_state.bindBuffer(GL_ARRAY_BUFFER, m_vbo.name());
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * t_numVertices, t_vertices);
+}
+
+/////////////////////////////////////////////////////////
+
+void Mesh::draw(GLStateCache& t_state) const
+{
+	if (m_pool)
+	{
+		m_pool->draw(t_state, m_poolId);
+		return;
+	}
+
+	t_state.bindVertexArray(m_vao.name());
+	glDrawElements(GL_TRIANGLES, m_numIndices, m_indexType, (char*)NULL + 0);
+}
+
+/////////////////////////////////////////////////////////
+
+GLuint Mesh::getVAO() const
+{
+	return m_pool ? m_pool->getVAO() : m_vao.name();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Releases the VAO and buffers; they are deleted once the GPU has finished with them
+/// </summary>
+void Mesh::unload()
+{
+	if (m_pool)
+	{
+		m_pool->free(m_poolId);
+		m_pool = nullptr;
+	}
+
+	m_vao.reset();
+	m_vbo.reset();
+	m_ibo.reset();
+	m_numIndices = 0;
+}
@@ -0,0 +1,75 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <GL/glew.h>
+#include <GLStateCache.h>
+#include <GLResources.h>
+
+typedef struct
+{
+	float coordinate[3];
+	float color[4];
+} Vertex;
+
+/// <summary>
+/// Fixed attribute locations, bound with glBindAttribLocation before linking,
+/// so a mesh's VAO works with any program that follows the convention.
+/// </summary>
+enum VertexAttributeLocation : GLuint
+{
+	POSITION_LOCATION = 0,
+	COLOR_LOCATION = 1
+};
+
+/// <summary>
+/// Describes one vertex attribute within a Vertex
+/// </summary>
+struct VertexAttribute
+{
+	GLuint location;
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	GLsizei offset; // bytes from the start of a Vertex
+};
+
+class GeometryPool;
+
+/// <summary>
+/// Owns the vertex buffer, index buffer and vertex array object of one mesh,
+/// or a range of a GeometryPool shared with other meshes.
+/// Attribute pointers are configured once in load(), so drawing is one bind plus one draw call.
+/// The objects come from GLResources and are released when the mesh is unloaded or destroyed.
+/// </summary>
+class Mesh
+{
+public:
+	static const VertexAttribute DEFAULT_LAYOUT[2];
+
+	static GLsizei indexSize(GLenum t_indexType); // bytes per GL_UNSIGNED_BYTE, _SHORT or _INT index
+
+	void load(GLResources& t_resources, GLStateCache& t_state, const Vertex* t_vertices, GLsizei t_numVertices,
+		const void* t_indices, GLsizei t_numIndices, GLenum t_indexType,
+		const VertexAttribute* t_layout = DEFAULT_LAYOUT, int t_numAttributes = 2);
+	void load(GeometryPool& t_pool, GLResources& t_resources, GLStateCache& t_state, const Vertex* t_vertices, GLsizei t_numVertices,
+		const void* t_indices, GLsizei t_numIndices, GLenum t_indexType);
+	void updateVertices(GLStateCache& t_state, const Vertex* t_vertices, GLsizei t_numVertices);
+	void draw(GLStateCache& t_state) const;
+	void unload();
+
+	GLuint getVAO() const; // the pool's VAO for pooled meshes, so they sort together
+	const GeometryPool* getPool() const { return m_pool; } // null if the mesh owns its buffers
+	uint32_t getPoolId() const { return m_poolId; }
+
+private:
+	GLVertexArray m_vao;
+	GLBuffer m_vbo;
+	GLBuffer m_ibo;
+	GLsizei m_numIndices = 0;
+	GLenum m_indexType = GL_UNSIGNED_BYTE;
+
+	GeometryPool* m_pool = nullptr;
+	uint32_t m_poolId = 0;
+};
+
+#endif
@@ -0,0 +1,233 @@
+#include <Metrics.h>
+
+#include <cstdarg>
+#include <cstdio>
+
+const uint64_t Metrics::FRAME_TIME_BUCKETS[FRAME_TIME_BUCKET_COUNT] = {
+	1000, 2000, 4000, 8000, 12500, 16700, 25000, 33300, 50000, 100000, 250000, 1000000
+};
+
+namespace
+{
+	const double FRAME_TIME_QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+	const char* COUNTER_NAMES[METRIC_COUNTER_COUNT] = {
+		"gpp_frames_total",
+		"gpp_draw_calls_total",
+		"gpp_uploaded_bytes_total",
+		"gpp_culled_objects_total"
+	};
+
+	const char* COUNTER_HELP[METRIC_COUNTER_COUNT] = {
+		"Frames rendered.",
+		"Draw calls issued to the driver; one multi-draw counts once.",
+		"Bytes uploaded to GPU buffers.",
+		"Objects skipped by occlusion culling."
+	};
+
+	/// <summary>
+	/// Appends printf-style text to a string
+	/// </summary>
+	void append(std::string& t_out, const char* t_format, ...)
+	{
+		char line[256];
+
+		va_list args;
+		va_start(args, t_format);
+		vsnprintf(line, sizeof(line), t_format, args);
+		va_end(args);
+
+		t_out += line;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+Histogram::Histogram() :
+	m_count{ 0 },
+	m_sum{ 0 }
+{
+	for (int i = 0; i < BUCKET_COUNT; i++)
+	{
+		m_buckets[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void Histogram::record(uint64_t t_value)
+{
+	m_buckets[bucketIndex(t_value)].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(t_value, std::memory_order_relaxed);
+}
+
+
+/////////////////////////////////////////////////////////
+
+/// <param name="t_quantile">0 - 1</param>
+/// <returns>0 if nothing has been recorded</returns>
+uint64_t Histogram::valueAtQuantile(double t_quantile) const
+{
+	const uint64_t total = getCount();
+	if (total == 0) return 0;
+
+	uint64_t target = static_cast<uint64_t>(t_quantile * total + 0.5);
+	if (target < 1) target = 1;
+	if (target > total) target = total;
+
+	uint64_t count = 0;
+	for (int i = 0; i < BUCKET_COUNT; i++)
+	{
+		count += m_buckets[i].load(std::memory_order_relaxed);
+		if (count >= target) return bucketHighest(i);
+	}
+
+	return bucketHighest(BUCKET_COUNT - 1);
+}
+
+/////////////////////////////////////////////////////////
+
+int Histogram::bucketIndex(uint64_t t_value)
+{
+	const uint64_t maxValue = (static_cast<uint64_t>(1) << MAX_BITS) - 1;
+	if (t_value > maxValue) t_value = maxValue;
+
+	if (t_value < SUB_BUCKETS)
+	{
+		return static_cast<int>(t_value);
+	}
+
+	int magnitude = SUB_BUCKET_BITS;
+	while ((t_value >> (magnitude + 1)) != 0) magnitude++;
+
+	const int shift = magnitude - SUB_BUCKET_BITS;
+	const uint64_t subBucket = (t_value >> shift) - SUB_BUCKETS;
+
+	return static_cast<int>(SUB_BUCKETS * (shift + 1) + subBucket);
+}
+
+/////////////////////////////////////////////////////////
+
+uint64_t Histogram::bucketLowest(int t_index)
+{
+	if (t_index < static_cast<int>(SUB_BUCKETS))
+	{
+		return static_cast<uint64_t>(t_index);
+	}
+
+	const int shift = t_index / static_cast<int>(SUB_BUCKETS) - 1;
+	const uint64_t subBucket = t_index % SUB_BUCKETS;
+
+	return (SUB_BUCKETS + subBucket) << shift;
+}
+
+/////////////////////////////////////////////////////////
+
+uint64_t Histogram::bucketHighest(int t_index)
+{
+	if (t_index < static_cast<int>(SUB_BUCKETS))
+	{
+		return static_cast<uint64_t>(t_index);
+	}
+
+	const int shift = t_index / static_cast<int>(SUB_BUCKETS) - 1;
+
+	return bucketLowest(t_index) + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+/////////////////////////////////////////////////////////
+
+Metrics::Metrics()
+{
+	for (int i = 0; i < METRIC_COUNTER_COUNT; i++)
+	{
+		m_counters[i].store(0, std::memory_order_relaxed);
+	}
+
+	for (int i = 0; i < FRAME_TIME_BUCKET_COUNT; i++)
+	{
+		m_frameTimeBuckets[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Records a frame time in the histogram and in the first Prometheus bucket
+/// whose bound it does not exceed. The histogram's buckets straddle those
+/// bounds, so the exported counts are kept separately to be exact.
+/// </summary>
+void Metrics::recordFrameTime(uint64_t t_microseconds)
+{
+	m_frameTime.record(t_microseconds);
+
+	for (int i = 0; i < FRAME_TIME_BUCKET_COUNT; i++)
+	{
+		if (t_microseconds <= FRAME_TIME_BUCKETS[i])
+		{
+			m_frameTimeBuckets[i].fetch_add(1, std::memory_order_relaxed);
+			break;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <returns>frames no longer than FRAME_TIME_BUCKETS[t_bucket]</returns>
+uint64_t Metrics::getFrameTimeAtOrBelow(int t_bucket) const
+{
+	uint64_t count = 0;
+
+	for (int i = 0; i <= t_bucket; i++)
+	{
+		count += m_frameTimeBuckets[i].load(std::memory_order_relaxed);
+	}
+
+	return count;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Formats every metric for a Prometheus scrape. Frame times are exported
+/// both as a histogram with fixed buckets, for aggregation across instances,
+/// and as a summary of quantiles read from the full-resolution histogram.
+/// </summary>
+std::string Metrics::toPrometheus() const
+{
+	std::string out;
+
+	const uint64_t count = m_frameTime.getCount();
+	const double sum = m_frameTime.getSum() / 1e6;
+
+	out += "# HELP gpp_frame_time_seconds Time between the starts of consecutive frames.\n";
+	out += "# TYPE gpp_frame_time_seconds histogram\n";
+	for (int i = 0; i < FRAME_TIME_BUCKET_COUNT; i++)
+	{
+		append(out, "gpp_frame_time_seconds_bucket{le=\"%g\"} %llu\n", FRAME_TIME_BUCKETS[i] / 1e6,
+			static_cast<unsigned long long>(getFrameTimeAtOrBelow(i)));
+	}
+	append(out, "gpp_frame_time_seconds_bucket{le=\"+Inf\"} %llu\n", static_cast<unsigned long long>(count));
+	append(out, "gpp_frame_time_seconds_sum %.6f\n", sum);
+	append(out, "gpp_frame_time_seconds_count %llu\n", static_cast<unsigned long long>(count));
+
+	out += "# HELP gpp_frame_time_quantile_seconds Frame time quantiles since start, to within 3%.\n";
+	out += "# TYPE gpp_frame_time_quantile_seconds summary\n";
+	for (double quantile : FRAME_TIME_QUANTILES)
+	{
+		append(out, "gpp_frame_time_quantile_seconds{quantile=\"%g\"} %.6f\n", quantile,
+			m_frameTime.valueAtQuantile(quantile) / 1e6);
+	}
+	append(out, "gpp_frame_time_quantile_seconds_sum %.6f\n", sum);
+	append(out, "gpp_frame_time_quantile_seconds_count %llu\n", static_cast<unsigned long long>(count));
+
+	for (int i = 0; i < METRIC_COUNTER_COUNT; i++)
+	{
+		append(out, "# HELP %s %s\n", COUNTER_NAMES[i], COUNTER_HELP[i]);
+		append(out, "# TYPE %s counter\n", COUNTER_NAMES[i]);
+		append(out, "%s %llu\n", COUNTER_NAMES[i], static_cast<unsigned long long>(get(static_cast<MetricCounter>(i))));
+	}
+
+	return out;
+}
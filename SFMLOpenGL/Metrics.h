@@ -0,0 +1,78 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// HDR-style histogram of non-negative integers, such as microseconds.
+/// Values below SUB_BUCKETS are counted exactly; above that every power of
+/// two is split into SUB_BUCKETS equal buckets, so any recorded value is
+/// known to within 1 / SUB_BUCKETS (about 3%) whatever its magnitude.
+/// record() is a pair of relaxed atomic increments, so one thread can record
+/// while others read without locks; readers see a near-consistent view.
+/// </summary>
+class Histogram
+{
+public:
+	static const int SUB_BUCKET_BITS = 5;
+	static const uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	static const int MAX_BITS = 36; // values are clamped below 2^36
+	static const int BUCKET_COUNT = static_cast<int>(SUB_BUCKETS) * (MAX_BITS - SUB_BUCKET_BITS + 1);
+
+	Histogram();
+
+	void record(uint64_t t_value);
+
+	uint64_t getCount() const { return m_count.load(std::memory_order_relaxed); }
+	uint64_t getSum() const { return m_sum.load(std::memory_order_relaxed); }
+	uint64_t valueAtQuantile(double t_quantile) const; // highest value of the bucket the quantile falls in
+
+	static int bucketIndex(uint64_t t_value);
+	static uint64_t bucketLowest(int t_index);
+	static uint64_t bucketHighest(int t_index);
+
+private:
+	std::atomic<uint64_t> m_buckets[BUCKET_COUNT];
+	std::atomic<uint64_t> m_count;
+	std::atomic<uint64_t> m_sum;
+};
+
+enum MetricCounter
+{
+	FRAMES_COUNTER,
+	DRAW_CALLS_COUNTER,
+	UPLOADED_BYTES_COUNTER,
+	CULLED_OBJECTS_COUNTER,
+	METRIC_COUNTER_COUNT
+};
+
+/// <summary>
+/// Runtime metrics of one instance. The render thread records, any thread
+/// may format them; everything is atomic, nothing takes a lock.
+/// </summary>
+class Metrics
+{
+public:
+	static const int FRAME_TIME_BUCKET_COUNT = 12;
+	static const uint64_t FRAME_TIME_BUCKETS[FRAME_TIME_BUCKET_COUNT]; // Prometheus bucket upper bounds, microseconds
+
+	Metrics();
+
+	void recordFrameTime(uint64_t t_microseconds);
+	void add(MetricCounter t_counter, uint64_t t_amount = 1) { m_counters[t_counter].fetch_add(t_amount, std::memory_order_relaxed); }
+
+	const Histogram& getFrameTime() const { return m_frameTime; }
+	uint64_t get(MetricCounter t_counter) const { return m_counters[t_counter].load(std::memory_order_relaxed); }
+	uint64_t getFrameTimeAtOrBelow(int t_bucket) const; // exact count for FRAME_TIME_BUCKETS[t_bucket]
+
+	std::string toPrometheus() const; // text exposition format 0.0.4
+
+private:
+	Histogram m_frameTime; // microseconds, for quantiles
+	std::atomic<uint64_t> m_frameTimeBuckets[FRAME_TIME_BUCKET_COUNT]; // frames in each bucket but none below it
+	std::atomic<uint64_t> m_counters[METRIC_COUNTER_COUNT];
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include <MetricsServer.h>
+#include <Debug.h>
+#include <Trace.h>
+
+#include <SFML/Network.hpp>
+
+#include <iostream>
+#include <string>
+
+namespace
+{
+	// How often the server thread checks for stop() while idle
+	const sf::Time POLL_INTERVAL = sf::milliseconds(100);
+
+	// A scrape request must arrive within this long after connecting
+	const sf::Time REQUEST_TIMEOUT = sf::seconds(1.0f);
+
+	const size_t MAX_REQUEST = 8192;
+}
+
+/////////////////////////////////////////////////////////
+
+MetricsServer::MetricsServer(const Metrics& t_metrics) :
+	m_metrics{ t_metrics },
+	m_stopping{ false },
+	m_listening{ false },
+	m_failed{ false },
+	m_scrapes{ 0 }
+{
+}
+
+/////////////////////////////////////////////////////////
+
+MetricsServer::~MetricsServer()
+{
+	stop();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Starts listening on t_port in the background
+/// </summary>
+/// <returns>false if the port could not be opened</returns>
+bool MetricsServer::start(unsigned short t_port)
+{
+	if (isRunning()) return true;
+
+	m_stopping = false;
+	m_listening = false;
+	m_failed = false;
+	m_thread = std::thread(&MetricsServer::serveLoop, this, t_port);
+
+	// Wait for the outcome of listen() so the caller can report it
+	while (!m_listening && !m_failed)
+	{
+		std::this_thread::yield();
+	}
+
+	if (m_failed)
+	{
+		m_thread.join();
+		return false;
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+void MetricsServer::stop()
+{
+	if (!isRunning()) return;
+
+	m_stopping = true;
+	m_thread.join();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Accepts one connection at a time, reads its request headers and answers
+/// with the metrics. Scrapes are rare and tiny, so there is no concurrency.
+/// </summary>
+void MetricsServer::serveLoop(unsigned short t_port)
+{
+	TRACE_THREAD_NAME("metrics server");
+
+	sf::TcpListener listener;
+
+	if (listener.listen(t_port) != sf::Socket::Done)
+	{
+		DEBUG_MSG("ERROR: Metrics server could not listen on port " + std::to_string(t_port));
+		m_failed = true;
+		return;
+	}
+
+	m_listening = true;
+
+	sf::SocketSelector selector;
+	selector.add(listener);
+
+	while (!m_stopping)
+	{
+		if (!selector.wait(POLL_INTERVAL))
+		{
+			continue;
+		}
+
+		sf::TcpSocket client;
+		if (listener.accept(client) != sf::Socket::Done)
+		{
+			continue;
+		}
+
+		// SFML 2.3 listens on every interface, so refuse anyone not on this machine
+		if (client.getRemoteAddress() != sf::IpAddress::LocalHost)
+		{
+			client.disconnect();
+			continue;
+		}
+
+		TRACE_SCOPE("MetricsServer::respond", "job");
+
+		// Read up to the blank line ending the headers; the request itself does not matter
+		std::string request;
+		sf::SocketSelector clientSelector;
+		clientSelector.add(client);
+
+		while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST
+			&& clientSelector.wait(REQUEST_TIMEOUT))
+		{
+			char buffer[1024];
+			size_t received = 0;
+
+			if (client.receive(buffer, sizeof(buffer), received) != sf::Socket::Done)
+			{
+				break;
+			}
+			request.append(buffer, received);
+		}
+
+		const std::string body = m_metrics.toPrometheus();
+		const std::string response = "HTTP/1.0 200 OK\r\n"
+			"Content-Type: text/plain; version=0.0.4\r\n"
+			"Content-Length: " + std::to_string(body.size()) + "\r\n"
+			"Connection: close\r\n"
+			"\r\n" + body;
+
+		client.send(response.data(), response.size());
+		client.disconnect();
+		m_scrapes++;
+	}
+}
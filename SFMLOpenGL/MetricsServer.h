@@ -0,0 +1,41 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <Metrics.h>
+
+#include <atomic>
+#include <thread>
+
+/// <summary>
+/// Serves Metrics over HTTP for Prometheus to scrape, on its own thread.
+/// Every request, whatever its path, gets the current metrics in text
+/// format. Only connections from the local machine are answered; scrape
+/// remote instances through a local agent. The render thread is never
+/// blocked: the server only reads Metrics' atomics.
+/// </summary>
+class MetricsServer
+{
+public:
+	explicit MetricsServer(const Metrics& t_metrics);
+	~MetricsServer();
+	MetricsServer(const MetricsServer&) = delete;
+	MetricsServer& operator=(const MetricsServer&) = delete;
+
+	bool start(unsigned short t_port);
+	void stop();
+
+	bool isRunning() const { return m_thread.joinable(); }
+	unsigned getScrapes() const { return m_scrapes; }
+
+private:
+	void serveLoop(unsigned short t_port);
+
+	const Metrics& m_metrics;
+	std::thread m_thread;
+	std::atomic<bool> m_stopping;
+	std::atomic<bool> m_listening;
+	std::atomic<bool> m_failed;
+	std::atomic<unsigned> m_scrapes;
+};
+
+#endif
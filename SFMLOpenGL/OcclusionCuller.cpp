@@ -0,0 +1,307 @@
+#include <OcclusionCuller.h>
+
+#include <algorithm>
+#include <math.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Box corner i has max x if bit 0 is set, max y if bit 1, max z if bit 2
+	const int BOX_TRIANGLES[12][3] = {
+		{ 0, 4, 6 }, { 0, 6, 2 }, // -x
+		{ 1, 3, 7 }, { 1, 7, 5 }, // +x
+		{ 0, 1, 5 }, { 0, 5, 4 }, // -y
+		{ 2, 6, 7 }, { 2, 7, 3 }, // +y
+		{ 0, 2, 3 }, { 0, 3, 1 }, // -z
+		{ 4, 5, 7 }, { 4, 7, 6 }  // +z
+	};
+
+	// Corners closer than this in clip w are treated as crossing the near plane
+	const float MIN_W = 1e-5f;
+}
+
+/////////////////////////////////////////////////////////
+
+OcclusionCuller::OcclusionCuller()
+{
+	std::fill(m_viewProjection, m_viewProjection + 16, 0.0f);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Allocates the depth buffer and its mip chain down to 1x1
+/// </summary>
+/// <param name="t_width">level 0 width; a quarter of the window is plenty</param>
+/// <param name="t_height">level 0 height</param>
+void OcclusionCuller::resize(unsigned t_width, unsigned t_height)
+{
+	m_levels.clear();
+
+	unsigned width = std::max(1u, t_width);
+	unsigned height = std::max(1u, t_height);
+
+	for (;;)
+	{
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.stride = (width + 3) & ~3u;
+		level.depth.assign(static_cast<size_t>(level.stride) * height, 1.0f);
+		m_levels.push_back(level);
+
+		if (width == 1 && height == 1) break;
+
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Clears level 0 to the far plane for a new camera
+/// </summary>
+void OcclusionCuller::beginFrame(const float t_viewProjection[16])
+{
+	std::copy(t_viewProjection, t_viewProjection + 16, m_viewProjection);
+
+	if (!m_levels.empty())
+	{
+		std::fill(m_levels[0].depth.begin(), m_levels[0].depth.end(), 1.0f);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Rasterizes the front faces of a box into level 0. Boxes crossing the
+/// near plane are skipped, which can only make the culler less aggressive.
+/// </summary>
+void OcclusionCuller::addOccluder(const BoundingBox& t_box)
+{
+	float window[8][3];
+
+	if (m_levels.empty() || !project(t_box, window))
+	{
+		return;
+	}
+
+	for (int i = 0; i < 12; i++)
+	{
+		rasterize(window[BOX_TRIANGLES[i][0]], window[BOX_TRIANGLES[i][1]], window[BOX_TRIANGLES[i][2]]);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Reduces each level into the next, keeping the farthest depth of every 2x2 block
+/// </summary>
+void OcclusionCuller::buildPyramid()
+{
+	for (size_t i = 1; i < m_levels.size(); i++)
+	{
+		const Level& source = m_levels[i - 1];
+		Level& target = m_levels[i];
+
+		for (unsigned y = 0; y < target.height; y++)
+		{
+			const float* row0 = &source.depth[static_cast<size_t>(2 * y) * source.stride];
+			const float* row1 = &source.depth[static_cast<size_t>(std::min(2 * y + 1, source.height - 1)) * source.stride];
+			float* out = &target.depth[static_cast<size_t>(y) * target.stride];
+
+			for (unsigned x = 0; x < target.width; x++)
+			{
+				const unsigned x0 = 2 * x;
+				const unsigned x1 = std::min(x0 + 1, source.width - 1);
+				out[x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Tests a box against the pyramid built this frame
+/// </summary>
+/// <returns>false if the box is off screen or behind the occluders everywhere it covers</returns>
+bool OcclusionCuller::isVisible(const BoundingBox& t_box) const
+{
+	float window[8][3];
+
+	if (m_levels.empty() || !project(t_box, window))
+	{
+		return true; // crosses the near plane, assume visible
+	}
+
+	float minX = window[0][0], maxX = window[0][0];
+	float minY = window[0][1], maxY = window[0][1];
+	float minZ = window[0][2];
+
+	for (int i = 1; i < 8; i++)
+	{
+		minX = std::min(minX, window[i][0]);
+		maxX = std::max(maxX, window[i][0]);
+		minY = std::min(minY, window[i][1]);
+		maxY = std::max(maxY, window[i][1]);
+		minZ = std::min(minZ, window[i][2]);
+	}
+
+	const Level& base = m_levels[0];
+
+	if (maxX < 0.0f || maxY < 0.0f || minX >= base.width || minY >= base.height || minZ > 1.0f)
+	{
+		return false;
+	}
+
+	// Every texel the rectangle touches, at level 0
+	const int x0 = std::max(0, static_cast<int>(floorf(minX)));
+	const int y0 = std::max(0, static_cast<int>(floorf(minY)));
+	const int x1 = std::min(static_cast<int>(base.width) - 1, static_cast<int>(floorf(maxX)));
+	const int y1 = std::min(static_cast<int>(base.height) - 1, static_cast<int>(floorf(maxY)));
+
+	// Coarsest useful level: the rectangle spans at most four texels each way
+	unsigned levelIndex = 0;
+	while (levelIndex + 1 < m_levels.size()
+		&& ((x1 >> levelIndex) - (x0 >> levelIndex) > 3 || (y1 >> levelIndex) - (y0 >> levelIndex) > 3))
+	{
+		levelIndex++;
+	}
+
+	const Level& level = m_levels[levelIndex];
+	const int lx0 = x0 >> levelIndex, lx1 = x1 >> levelIndex;
+	const int ly0 = y0 >> levelIndex, ly1 = y1 >> levelIndex;
+
+#ifdef OCCLUSION_SSE2
+	const __m128 nearest = _mm_set1_ps(minZ);
+	const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+#endif
+
+	for (int y = ly0; y <= ly1; y++)
+	{
+		const float* row = &level.depth[static_cast<size_t>(y) * level.stride];
+
+#ifdef OCCLUSION_SSE2
+		// Aligned groups of four, with lanes outside [lx0, lx1] masked off
+		for (int x = lx0 & ~3; x <= lx1; x += 4)
+		{
+			const __m128i column = _mm_add_epi32(_mm_set1_epi32(x), lanes);
+			const __m128i inRange = _mm_andnot_si128(_mm_cmplt_epi32(column, _mm_set1_epi32(lx0)),
+				_mm_cmplt_epi32(column, _mm_set1_epi32(lx1 + 1)));
+			const __m128 inFront = _mm_cmple_ps(nearest, _mm_loadu_ps(row + x));
+
+			if (_mm_movemask_ps(_mm_and_ps(inFront, _mm_castsi128_ps(inRange))) != 0)
+			{
+				return true;
+			}
+		}
+#else
+		for (int x = lx0; x <= lx1; x++)
+		{
+			if (minZ <= row[x]) return true;
+		}
+#endif
+	}
+
+	return false;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Transforms the eight corners of a box to level 0 window coordinates
+/// </summary>
+/// <returns>false if any corner is on or behind the camera plane</returns>
+bool OcclusionCuller::project(const BoundingBox& t_box, float t_window[8][3]) const
+{
+	const float* m = m_viewProjection;
+	const Level& base = m_levels[0];
+
+	for (int i = 0; i < 8; i++)
+	{
+		const float x = (i & 1) ? t_box.max[0] : t_box.min[0];
+		const float y = (i & 2) ? t_box.max[1] : t_box.min[1];
+		const float z = (i & 4) ? t_box.max[2] : t_box.min[2];
+
+		const float clipX = m[0] * x + m[4] * y + m[8] * z + m[12];
+		const float clipY = m[1] * x + m[5] * y + m[9] * z + m[13];
+		const float clipZ = m[2] * x + m[6] * y + m[10] * z + m[14];
+		const float clipW = m[3] * x + m[7] * y + m[11] * z + m[15];
+
+		// Near plane is z = -w; anything in front of it but this close is treated the same
+		if (clipW < MIN_W || clipZ < -clipW)
+		{
+			return false;
+		}
+
+		t_window[i][0] = (clipX / clipW * 0.5f + 0.5f) * base.width;
+		t_window[i][1] = (clipY / clipW * 0.5f + 0.5f) * base.height;
+		t_window[i][2] = clipZ / clipW * 0.5f + 0.5f;
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Writes one counter-clockwise triangle into level 0 at the farthest of its vertex depths
+/// </summary>
+void OcclusionCuller::rasterize(const float* t_v0, const float* t_v1, const float* t_v2)
+{
+	const float area = (t_v1[0] - t_v0[0]) * (t_v2[1] - t_v0[1]) - (t_v2[0] - t_v0[0]) * (t_v1[1] - t_v0[1]);
+
+	if (area <= 0.0f)
+	{
+		return; // back-facing or degenerate
+	}
+
+	const float depth = std::max(std::max(t_v0[2], t_v1[2]), t_v2[2]);
+	if (depth >= 1.0f)
+	{
+		return;
+	}
+
+	Level& base = m_levels[0];
+
+	const int minX = std::max(0, static_cast<int>(ceilf(std::min(std::min(t_v0[0], t_v1[0]), t_v2[0]) - 0.5f)));
+	const int minY = std::max(0, static_cast<int>(ceilf(std::min(std::min(t_v0[1], t_v1[1]), t_v2[1]) - 0.5f)));
+	const int maxX = std::min(static_cast<int>(base.width) - 1, static_cast<int>(floorf(std::max(std::max(t_v0[0], t_v1[0]), t_v2[0]) - 0.5f)));
+	const int maxY = std::min(static_cast<int>(base.height) - 1, static_cast<int>(floorf(std::max(std::max(t_v0[1], t_v1[1]), t_v2[1]) - 0.5f)));
+
+	const float* v[3] = { t_v0, t_v1, t_v2 };
+	float a[3], b[3], c[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		const float* from = v[(i + 1) % 3];
+		const float* to = v[(i + 2) % 3];
+		a[i] = from[1] - to[1];
+		b[i] = to[0] - from[0];
+		c[i] = from[0] * to[1] - from[1] * to[0];
+	}
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		const float py = static_cast<float>(y) + 0.5f;
+		float* row = &base.depth[static_cast<size_t>(y) * base.stride];
+
+		for (int x = minX; x <= maxX; x++)
+		{
+			const float px = static_cast<float>(x) + 0.5f;
+
+			if (a[0] * px + b[0] * py + c[0] >= 0.0f
+				&& a[1] * px + b[1] * py + c[1] >= 0.0f
+				&& a[2] * px + b[2] * py + c[2] >= 0.0f)
+			{
+				row[x] = std::min(row[x], depth);
+			}
+		}
+	}
+}
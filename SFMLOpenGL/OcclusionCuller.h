@@ -0,0 +1,64 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <vector>
+
+/// <summary>
+/// World-space axis-aligned bounding box
+/// </summary>
+struct BoundingBox
+{
+	float min[3];
+	float max[3];
+};
+
+/// <summary>
+/// Hierarchical-Z occlusion culling on the CPU.
+///
+/// Each frame, occluder boxes (ideally the nearest, largest objects) are
+/// rasterized into a low-resolution depth buffer, writing the farthest depth
+/// of each front-facing triangle so the buffer never claims more occlusion
+/// than the geometry provides. buildPyramid() then reduces it into mips that
+/// keep the maximum depth of each 2x2 block. isVisible() projects a box to a
+/// screen rectangle and its nearest depth, picks the mip where that rectangle
+/// spans a few texels, and compares against them four at a time.
+///
+/// Depth follows GL window conventions: 0 at the near plane, 1 at the far plane.
+/// </summary>
+class OcclusionCuller
+{
+public:
+	OcclusionCuller();
+
+	void resize(unsigned t_width, unsigned t_height);
+
+	// t_viewProjection is column-major projection * view
+	void beginFrame(const float t_viewProjection[16]);
+	void addOccluder(const BoundingBox& t_box);
+	void buildPyramid();
+
+	bool isVisible(const BoundingBox& t_box) const;
+
+	unsigned getWidth() const { return m_levels.empty() ? 0 : m_levels[0].width; }
+	unsigned getHeight() const { return m_levels.empty() ? 0 : m_levels[0].height; }
+	unsigned getLevelCount() const { return static_cast<unsigned>(m_levels.size()); }
+
+private:
+	/// <summary>
+	/// One mip. Rows are padded to a multiple of four floats, so any aligned
+	/// group of four texels can be loaded without running off the end.
+	/// </summary>
+	struct Level
+	{
+		unsigned width, height, stride;
+		std::vector<float> depth;
+	};
+
+	bool project(const BoundingBox& t_box, float t_window[8][3]) const;
+	void rasterize(const float* t_v0, const float* t_v1, const float* t_v2);
+
+	std::vector<Level> m_levels;
+	float m_viewProjection[16];
+};
+
+#endif
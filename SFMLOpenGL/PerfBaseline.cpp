@@ -0,0 +1,226 @@
+#include <PerfBaseline.h>
+#include <Debug.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <math.h>
+#include <sstream>
+
+const double PerfBaseline::DEFAULT_TOLERANCE{ 0.10 };
+const double PerfBaseline::NOISE_FLOOR_MS{ 0.05 };
+
+namespace
+{
+	/// <summary>
+	/// Reads the value following "t_key": in t_object, as a string or a number
+	/// </summary>
+	bool field(const std::string& t_object, const std::string& t_key, std::string& t_value)
+	{
+		size_t at = t_object.find("\"" + t_key + "\"");
+		if (at == std::string::npos) return false;
+
+		at = t_object.find(':', at);
+		if (at == std::string::npos) return false;
+
+		at = t_object.find_first_not_of(" \t\r\n", at + 1);
+		if (at == std::string::npos) return false;
+
+		if (t_object[at] == '"')
+		{
+			size_t end = t_object.find('"', at + 1);
+			if (end == std::string::npos) return false;
+			t_value = t_object.substr(at + 1, end - at - 1);
+		}
+		else
+		{
+			size_t end = t_object.find_first_of(",}\r\n", at);
+			t_value = t_object.substr(at, end - at);
+		}
+
+		return true;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Median and the order statistics bracketing it with 95% confidence,
+/// n / 2 -+ 1.96 * sqrt(n) / 2, which holds whatever the distribution
+/// </summary>
+PerfStat PerfBaseline::summarize(const std::string& t_name, std::vector<double> t_samples)
+{
+	PerfStat stat;
+	stat.name = t_name;
+	stat.samples = static_cast<unsigned>(t_samples.size());
+
+	if (t_samples.empty())
+	{
+		return stat;
+	}
+
+	std::sort(t_samples.begin(), t_samples.end());
+
+	const size_t n = t_samples.size();
+	stat.median = (n % 2) ? t_samples[n / 2] : 0.5 * (t_samples[n / 2 - 1] + t_samples[n / 2]);
+
+	const double spread = 1.96 * sqrt(static_cast<double>(n)) / 2.0;
+	const double lowRank = floor(n / 2.0 - spread);
+	const double highRank = ceil(n / 2.0 + spread);
+
+	stat.low = t_samples[static_cast<size_t>(std::max(0.0, lowRank))];
+	stat.high = t_samples[static_cast<size_t>(std::min(static_cast<double>(n - 1), highRank))];
+
+	return stat;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Reads a file written by save(). Only the fields save() writes are understood.
+/// </summary>
+/// <returns>false if the file is missing or holds no stats</returns>
+bool PerfBaseline::load(const std::string& t_fileSrc)
+{
+	std::ifstream input{ t_fileSrc };
+	if (!input.is_open())
+	{
+		return false;
+	}
+
+	std::stringstream contents;
+	contents << input.rdbuf();
+	const std::string json = contents.str();
+
+	std::string value;
+	frames = field(json, "frames", value) ? static_cast<unsigned>(atoi(value.c_str())) : 0;
+	stats.clear();
+
+	size_t at = json.find("\"stats\"");
+	if (at == std::string::npos)
+	{
+		DEBUG_MSG("ERROR: No stats in perf baseline " + t_fileSrc);
+		return false;
+	}
+
+	while ((at = json.find('{', at)) != std::string::npos)
+	{
+		const size_t end = json.find('}', at);
+		if (end == std::string::npos) break;
+
+		const std::string object = json.substr(at, end - at + 1);
+		PerfStat stat;
+
+		if (field(object, "name", stat.name))
+		{
+			if (field(object, "median", value)) stat.median = atof(value.c_str());
+			if (field(object, "low", value)) stat.low = atof(value.c_str());
+			if (field(object, "high", value)) stat.high = atof(value.c_str());
+			if (field(object, "samples", value)) stat.samples = static_cast<unsigned>(atoi(value.c_str()));
+			stats.push_back(stat);
+		}
+
+		at = end + 1;
+	}
+
+	if (stats.empty())
+	{
+		DEBUG_MSG("ERROR: No stats in perf baseline " + t_fileSrc);
+		return false;
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+bool PerfBaseline::save(const std::string& t_fileSrc) const
+{
+	std::ofstream output{ t_fileSrc };
+	if (!output.is_open())
+	{
+		DEBUG_MSG("ERROR: Could not write perf baseline " + t_fileSrc);
+		return false;
+	}
+
+	output << "{\n  \"frames\": " << frames << ",\n  \"stats\": [\n";
+
+	for (size_t i = 0; i < stats.size(); i++)
+	{
+		char line[256];
+		snprintf(line, sizeof(line), "    { \"name\": \"%s\", \"median\": %.6f, \"low\": %.6f, \"high\": %.6f, \"samples\": %u }%s\n",
+			stats[i].name.c_str(), stats[i].median, stats[i].low, stats[i].high, stats[i].samples,
+			i + 1 < stats.size() ? "," : "");
+		output << line;
+	}
+
+	output << "  ]\n}\n";
+	return output.good();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Prints a table of baseline against current medians, with intervals and
+/// the verdict per stat
+/// </summary>
+/// <param name="t_current">this run</param>
+/// <param name="t_tolerance">relative growth of the median allowed</param>
+/// <returns>the number of stats that regressed</returns>
+int PerfBaseline::compare(const PerfBaseline& t_current, std::ostream& t_out, double t_tolerance) const
+{
+	int regressions = 0;
+	char line[256];
+
+	snprintf(line, sizeof(line), "%-16s %22s %22s %9s  %s\n", "phase", "baseline ms [95% CI]", "current ms [95% CI]", "change", "result");
+	t_out << line;
+
+	for (const PerfStat& current : t_current.stats)
+	{
+		const PerfStat* base = find(current.name);
+
+		if (!base)
+		{
+			snprintf(line, sizeof(line), "%-16s %22s %8.3f [%5.3f,%5.3f] %9s  new\n",
+				current.name.c_str(), "-", current.median, current.low, current.high, "-");
+			t_out << line;
+			continue;
+		}
+
+		const double delta = current.median - base->median;
+		const double change = base->median > 0.0 ? 100.0 * delta / base->median : 0.0;
+		const bool significant = fabs(delta) > NOISE_FLOOR_MS && fabs(delta) > t_tolerance * base->median;
+
+		const char* result = "ok";
+		if (significant && current.low > base->high)
+		{
+			result = "REGRESSED";
+			regressions++;
+		}
+		else if (significant && current.high < base->low)
+		{
+			result = "faster";
+		}
+
+		snprintf(line, sizeof(line), "%-16s %8.3f [%5.3f,%5.3f] %8.3f [%5.3f,%5.3f] %+8.1f%%  %s\n",
+			current.name.c_str(), base->median, base->low, base->high,
+			current.median, current.low, current.high, change, result);
+		t_out << line;
+	}
+
+	return regressions;
+}
+
+/////////////////////////////////////////////////////////
+
+const PerfStat* PerfBaseline::find(const std::string& t_name) const
+{
+	for (const PerfStat& stat : stats)
+	{
+		if (stat.name == t_name) return &stat;
+	}
+
+	return nullptr;
+}
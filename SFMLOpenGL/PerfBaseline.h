@@ -0,0 +1,55 @@
+#ifndef PERF_BASELINE_H
+#define PERF_BASELINE_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Median of one timing series with a distribution-free 95% confidence interval
+/// </summary>
+struct PerfStat
+{
+	std::string name;
+	double median = 0.0; // milliseconds
+	double low = 0.0;
+	double high = 0.0;
+	unsigned samples = 0;
+};
+
+/// <summary>
+/// Per-phase timings of a perf run, saved as JSON next to the code it guards:
+///
+///   {
+///     "frames": 600,
+///     "stats": [
+///       { "name": "draw cpu", "median": 0.05, "low": 0.048, "high": 0.052, "samples": 600 }
+///     ]
+///   }
+///
+/// compare() flags a phase as regressed only if the new interval lies wholly
+/// above the baseline's and the median grew by more than both the relative
+/// tolerance and an absolute noise floor, so a single noisy run does not fail.
+/// </summary>
+class PerfBaseline
+{
+public:
+	static const double DEFAULT_TOLERANCE; // relative growth of the median, 0.1 = 10%
+	static const double NOISE_FLOOR_MS; // smaller changes are never flagged
+
+	static PerfStat summarize(const std::string& t_name, std::vector<double> t_samples);
+
+	bool load(const std::string& t_fileSrc);
+	bool save(const std::string& t_fileSrc) const;
+
+	// Prints one row per stat; returns the number of regressions
+	int compare(const PerfBaseline& t_current, std::ostream& t_out, double t_tolerance = DEFAULT_TOLERANCE) const;
+
+	unsigned frames = 0;
+	std::vector<PerfStat> stats;
+
+private:
+	const PerfStat* find(const std::string& t_name) const;
+};
+
+#endif
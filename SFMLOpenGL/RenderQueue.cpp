@@ -0,0 +1,338 @@
+#include <RenderQueue.h>
+#include <GeometryPool.h>
+#include <Trace.h>
+
+#include <algorithm>
+
+/// <summary>
+/// Pre-allocates storage so that submit() never allocates
+/// </summary>
+/// <param name="t_capacity">maximum packets per frame, extra packets are dropped</param>
+RenderQueue::RenderQueue(size_t t_capacity) :
+	m_packets(t_capacity),
+	m_entries(t_capacity),
+	m_scratch(t_capacity),
+	m_count{ 0 },
+	m_dropped{ 0 },
+	m_drawCalls{ 0 },
+	m_dataAlignment{ 1 }
+{
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Creates the command and DrawData buffers, sized for a full queue where
+/// every packet starts a new batch. Programs used with the indirect path
+/// must be built from indirect_vert_shader.
+/// </summary>
+/// <returns>false if the context cannot draw indirectly; the direct path is used</returns>
+bool RenderQueue::initializeIndirect(GLResources& t_resources, GLStateCache& t_state)
+{
+	if (!GLEW_VERSION_4_3 || !GLEW_ARB_shader_draw_parameters)
+	{
+		return false;
+	}
+
+	GLint alignment = 0;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	m_dataAlignment = std::max<size_t>(1, (static_cast<size_t>(alignment) + sizeof(DrawData) - 1) / sizeof(DrawData));
+
+	m_commandBuffer = t_resources.createBuffer();
+	t_resources.bufferData(m_commandBuffer.handle(), GL_DRAW_INDIRECT_BUFFER,
+		sizeof(DrawElementsIndirectCommand) * m_packets.size(), NULL, GL_STREAM_DRAW);
+
+	m_drawDataBuffer = t_resources.createBuffer();
+	t_resources.bufferData(m_drawDataBuffer.handle(), GL_SHADER_STORAGE_BUFFER,
+		sizeof(DrawData) * m_packets.size() * m_dataAlignment, NULL, GL_STREAM_DRAW);
+
+	m_commands.reserve(m_packets.size());
+	m_drawData.reserve(m_packets.size() * m_dataAlignment);
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Releases the indirect buffers and goes back to one draw call per packet
+/// </summary>
+void RenderQueue::unloadIndirect()
+{
+	m_commandBuffer.reset();
+	m_drawDataBuffer.reset();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Packs the sort criteria into a key. IDs are truncated to their field width,
+/// depth (0 - 1, nearest first) is quantised to 24 bits.
+/// </summary>
+uint64_t RenderQueue::makeKey(unsigned t_pass, unsigned t_program, unsigned t_material, unsigned t_mesh, float t_depth)
+{
+	if (t_depth < 0.0f) t_depth = 0.0f;
+	if (t_depth > 1.0f) t_depth = 1.0f;
+
+	uint64_t depth = static_cast<uint64_t>(t_depth * 0xFFFFFF);
+
+	return (static_cast<uint64_t>(t_pass & 0xF) << 60)
+		| (static_cast<uint64_t>(t_program & 0xFFF) << 48)
+		| (static_cast<uint64_t>(t_material & 0xFFF) << 36)
+		| (static_cast<uint64_t>(t_mesh & 0xFFF) << 24)
+		| depth;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Records a packet. Lock-free: each caller claims a slot with one atomic increment.
+/// </summary>
+/// <returns>false if the queue is full and the packet was dropped</returns>
+bool RenderQueue::submit(uint64_t t_key, const DrawPacket& t_packet)
+{
+	size_t slot = m_count.fetch_add(1, std::memory_order_relaxed);
+
+	if (slot >= m_entries.size())
+	{
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	m_packets[slot] = t_packet;
+	m_entries[slot].key = t_key;
+	m_entries[slot].packet = static_cast<uint32_t>(slot);
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+size_t RenderQueue::size() const
+{
+	size_t count = m_count.load();
+	return (count < m_entries.size()) ? count : m_entries.size();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// LSD radix sort of the keys, one byte per pass. Passes where every key
+/// shares the same byte are skipped, so unused key fields cost nothing.
+/// </summary>
+void RenderQueue::sort()
+{
+	TRACE_SCOPE("RenderQueue::sort", "cpu");
+
+	const size_t count = size();
+	Entry* src = m_entries.data();
+	Entry* dst = m_scratch.data();
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t histogram[256] = { 0 };
+
+		for (size_t i = 0; i < count; i++)
+		{
+			histogram[(src[i].key >> shift) & 0xFF]++;
+		}
+
+		if (count == 0 || histogram[(src[0].key >> shift) & 0xFF] == count)
+		{
+			continue; // all keys share this byte
+		}
+
+		size_t offset = 0;
+		for (int b = 0; b < 256; b++)
+		{
+			size_t bucket = histogram[b];
+			histogram[b] = offset;
+			offset += bucket;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+		}
+
+		Entry* swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (src != m_entries.data())
+	{
+		std::copy(src, src + count, m_entries.data());
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Issues the packets in sorted order. Program and VAO changes go through
+/// the state cache, so runs of equal keys bind once.
+/// </summary>
+void RenderQueue::execute(GLStateCache& t_state)
+{
+	TRACE_SCOPE("RenderQueue::execute", "gl");
+
+	m_drawCalls = 0;
+
+	if (isIndirect())
+	{
+		executeIndirect(t_state);
+	}
+	else
+	{
+		executeDirect(t_state);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// One draw call per packet, with DrawData passed as the "model" uniform
+/// </summary>
+void RenderQueue::executeDirect(GLStateCache& t_state)
+{
+	const size_t count = size();
+	GLuint program = 0;
+	GLint modelLocation = -1;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const DrawPacket& packet = m_packets[m_entries[i].packet];
+
+		t_state.useProgram(packet.program);
+
+		if (packet.program != program)
+		{
+			program = packet.program;
+
+			std::map<GLuint, GLint>::iterator it = m_modelLocations.find(program);
+			if (it == m_modelLocations.end())
+			{
+				it = m_modelLocations.insert(std::make_pair(program, glGetUniformLocation(program, "model"))).first;
+			}
+			modelLocation = it->second;
+		}
+
+		if (modelLocation >= 0)
+		{
+			glUniformMatrix4fv(modelLocation, 1, GL_FALSE, packet.data.model);
+		}
+
+		packet.mesh->draw(t_state);
+		m_drawCalls++;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Groups consecutive pooled packets into batches, uploads every command and
+/// DrawData in one go, then issues one multi-draw per batch. Each batch's
+/// DrawData is bound as its own range, so gl_DrawIDARB indexes it from 0.
+/// Meshes outside a GeometryPool form single-draw batches of their own.
+/// </summary>
+void RenderQueue::executeIndirect(GLStateCache& t_state)
+{
+	const size_t count = size();
+
+	m_batches.clear();
+	m_commands.clear();
+	m_drawData.clear();
+
+	const GeometryPool* batchPool = nullptr;
+	GLenum batchIndexType = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const DrawPacket& packet = m_packets[m_entries[i].packet];
+		const GeometryPool* pool = packet.mesh->getPool();
+
+		const bool extends = !m_batches.empty() && pool != nullptr && pool == batchPool
+			&& m_batches.back().program == packet.program
+			&& pool->getRange(packet.mesh->getPoolId()).indexType == batchIndexType;
+
+		if (!extends)
+		{
+			Batch batch;
+			batch.program = packet.program;
+			batch.mesh = packet.mesh;
+			batch.firstCommand = m_commands.size();
+			batch.firstData = (m_drawData.size() + m_dataAlignment - 1) / m_dataAlignment * m_dataAlignment;
+			batch.count = 0;
+			m_batches.push_back(batch);
+
+			m_drawData.resize(batch.firstData);
+			batchPool = pool;
+			batchIndexType = pool ? pool->getRange(packet.mesh->getPoolId()).indexType : 0;
+		}
+
+		if (pool)
+		{
+			const GeometryRange& range = pool->getRange(packet.mesh->getPoolId());
+
+			DrawElementsIndirectCommand command;
+			command.count = range.numIndices;
+			command.instanceCount = 1;
+			command.firstIndex = static_cast<GLuint>(range.indexOffset / Mesh::indexSize(range.indexType));
+			command.baseVertex = range.baseVertex;
+			command.baseInstance = 0;
+			m_commands.push_back(command);
+		}
+
+		m_drawData.push_back(packet.data);
+		m_batches.back().count++;
+	}
+
+	if (m_batches.empty())
+	{
+		return;
+	}
+
+	// Orphan and refill, so a second execute() in the frame does not wait on the first
+	if (!m_commands.empty())
+	{
+		t_state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer.name());
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * m_packets.size(), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * m_commands.size(), m_commands.data());
+	}
+
+	t_state.bindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawDataBuffer.name());
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DrawData) * m_packets.size() * m_dataAlignment, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(DrawData) * m_drawData.size(), m_drawData.data());
+
+	for (const Batch& batch : m_batches)
+	{
+		t_state.useProgram(batch.program);
+
+		// Also sets the generic binding to the same buffer, which matches the shadow
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, m_drawDataBuffer.name(),
+			sizeof(DrawData) * batch.firstData, sizeof(DrawData) * batch.count);
+
+		const GeometryPool* pool = batch.mesh->getPool();
+
+		if (pool)
+		{
+			t_state.bindVertexArray(pool->getVAO());
+			glMultiDrawElementsIndirect(GL_TRIANGLES, pool->getRange(batch.mesh->getPoolId()).indexType,
+				(char*)NULL + sizeof(DrawElementsIndirectCommand) * batch.firstCommand, batch.count, 0);
+		}
+		else
+		{
+			batch.mesh->draw(t_state);
+		}
+
+		m_drawCalls++;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void RenderQueue::clear()
+{
+	m_count.store(0);
+	m_dropped.store(0);
+}
@@ -0,0 +1,125 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <GL/glew.h>
+#include <GLStateCache.h>
+#include <GLResources.h>
+#include <Mesh.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/// <summary>
+/// Per-draw constants. The indirect path reads them from a storage buffer
+/// indexed by gl_DrawIDARB; the direct path sets the "model" uniform.
+/// Layout matches the std430 DrawData array in indirect_vert_shader.
+/// </summary>
+struct DrawData
+{
+	float model[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f }; // column-major
+};
+
+/// <summary>
+/// Everything needed to issue one draw on the render thread
+/// </summary>
+struct DrawPacket
+{
+	GLuint program;
+	const Mesh* mesh;
+	DrawData data;
+};
+
+/// <summary>
+/// Command layout read by glMultiDrawElementsIndirect
+/// </summary>
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex; // in indices, not bytes
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+/// <summary>
+/// Collects draw packets from any thread, each tagged with a 64-bit sort key,
+/// then radix-sorts and submits them from the render thread so that packets
+/// sharing a program and mesh are drawn back to back.
+///
+/// With the indirect path enabled, each run of packets sharing a program,
+/// GeometryPool and index type becomes one glMultiDrawElementsIndirect, and
+/// all their DrawData goes to the GPU in a single upload. Otherwise every
+/// packet is its own draw call.
+///
+/// Key layout, most significant first:
+///   pass 4 bits | program 12 bits | material 12 bits | mesh 12 bits | depth 24 bits
+/// </summary>
+class RenderQueue
+{
+public:
+	static const GLuint DRAW_DATA_BINDING = 1; // shader storage binding of the DrawData array
+
+	explicit RenderQueue(size_t t_capacity = 4096);
+
+	// Needs GL 4.3 and ARB_shader_draw_parameters; returns false and stays direct without them
+	bool initializeIndirect(GLResources& t_resources, GLStateCache& t_state);
+	void unloadIndirect();
+	bool isIndirect() const { return m_commandBuffer.name() != 0; }
+
+	static uint64_t makeKey(unsigned t_pass, unsigned t_program, unsigned t_material, unsigned t_mesh, float t_depth);
+
+	// Safe to call from any thread between clear() and sort()
+	bool submit(uint64_t t_key, const DrawPacket& t_packet);
+
+	// Render thread only
+	void sort();
+	void execute(GLStateCache& t_state);
+	void clear();
+
+	size_t size() const;
+	unsigned getDropped() const { return m_dropped.load(); }
+	unsigned getDrawCalls() const { return m_drawCalls; } // issued by the last execute()
+
+private:
+	struct Entry
+	{
+		uint64_t key;
+		uint32_t packet;
+	};
+
+	/// <summary>
+	/// One run of sorted packets drawn together by the indirect path
+	/// </summary>
+	struct Batch
+	{
+		GLuint program;
+		const Mesh* mesh; // first mesh of the run; the only one if it is not pooled
+		size_t firstCommand;
+		size_t firstData; // aligned for glBindBufferRange
+		GLsizei count;
+	};
+
+	void executeDirect(GLStateCache& t_state);
+	void executeIndirect(GLStateCache& t_state);
+
+	std::vector<DrawPacket> m_packets;
+	std::vector<Entry> m_entries;
+	std::vector<Entry> m_scratch;
+	std::atomic<size_t> m_count;
+	std::atomic<unsigned> m_dropped;
+	unsigned m_drawCalls;
+	std::map<GLuint, GLint> m_modelLocations; // looked up on a program's first direct draw; programs are not relinked
+
+	// Indirect path, rebuilt by every execute()
+	GLBuffer m_commandBuffer;
+	GLBuffer m_drawDataBuffer;
+	size_t m_dataAlignment; // in DrawData entries
+	std::vector<Batch> m_batches;
+	std::vector<DrawElementsIndirectCommand> m_commands;
+	std::vector<DrawData> m_drawData;
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include <SceneSnapshot.h>
+#include <Debug.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char MAGIC[4] = { 'G', 'P', 'P', 'S' };
+	const uint32_t BYTE_ORDER_MARK = 0x01020304; // reads differently on a foreign-endian host
+	const size_t BLOCK_ALIGNMENT = 16;
+
+	enum BlockType
+	{
+		TRANSLATION_X,
+		TRANSLATION_Y,
+		TRANSLATION_Z,
+		OBJECT_MESH,
+		ANIMATION_TIME,
+		MESH_FIRST_VERTEX,
+		MESH_VERTEX_COUNT,
+		VERTICES,
+		NUM_BLOCKS
+	};
+
+	struct BlockEntry
+	{
+		uint64_t offset; // from the start of the file
+		uint64_t size; // bytes
+	};
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t byteOrder;
+		uint32_t version;
+		uint32_t headerSize;
+		uint32_t objectCount;
+		uint32_t meshCount;
+		uint32_t vertexCount;
+		uint32_t blockCount;
+		BlockEntry blocks[NUM_BLOCKS];
+	};
+
+	size_t align(size_t t_offset)
+	{
+		return (t_offset + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+SceneSnapshot::SceneSnapshot() :
+	m_data{ nullptr },
+	m_size{ 0 }
+#if defined(_WIN32)
+	, m_file{ nullptr },
+	m_mapping{ nullptr }
+#endif
+{
+}
+
+/////////////////////////////////////////////////////////
+
+SceneSnapshot::~SceneSnapshot()
+{
+	close();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Lays the state out as a file image in memory and writes it with one call
+/// </summary>
+/// <param name="t_path">file to create or overwrite</param>
+/// <param name="t_state">scene to save</param>
+/// <returns>true if the whole image was written</returns>
+bool SceneSnapshot::save(const std::string& t_path, const SceneState& t_state)
+{
+	const void* sources[NUM_BLOCKS] = {
+		t_state.translationX, t_state.translationY, t_state.translationZ,
+		t_state.mesh, t_state.animationTime,
+		t_state.meshFirstVertex, t_state.meshVertexCount,
+		t_state.vertices
+	};
+	const size_t sizes[NUM_BLOCKS] = {
+		sizeof(float) * t_state.objectCount, sizeof(float) * t_state.objectCount, sizeof(float) * t_state.objectCount,
+		sizeof(uint32_t) * t_state.objectCount, sizeof(float) * t_state.objectCount,
+		sizeof(uint32_t) * t_state.meshCount, sizeof(uint32_t) * t_state.meshCount,
+		sizeof(Vertex) * t_state.vertexCount
+	};
+
+	Header header = {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.version = VERSION;
+	header.headerSize = sizeof(Header);
+	header.objectCount = t_state.objectCount;
+	header.meshCount = t_state.meshCount;
+	header.vertexCount = t_state.vertexCount;
+	header.blockCount = NUM_BLOCKS;
+
+	size_t offset = align(sizeof(Header));
+	for (int i = 0; i < NUM_BLOCKS; i++)
+	{
+		header.blocks[i].offset = offset;
+		header.blocks[i].size = sizes[i];
+		offset = align(offset + sizes[i]);
+	}
+
+	std::vector<unsigned char> image(offset, 0);
+	std::memcpy(image.data(), &header, sizeof(Header));
+	for (int i = 0; i < NUM_BLOCKS; i++)
+	{
+		if (sizes[i] > 0) std::memcpy(image.data() + header.blocks[i].offset, sources[i], sizes[i]);
+	}
+
+	FILE* file = std::fopen(t_path.c_str(), "wb");
+	if (!file)
+	{
+		DEBUG_MSG("ERROR: Could not create snapshot " + t_path);
+		return false;
+	}
+
+	bool written = std::fwrite(image.data(), 1, image.size(), file) == image.size();
+	written = (std::fclose(file) == 0) && written;
+
+	return written;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Maps a snapshot read-only and fixes up the state pointers into it
+/// </summary>
+/// <param name="t_path">snapshot file</param>
+/// <returns>false if the file is missing, from another version or malformed</returns>
+bool SceneSnapshot::open(const std::string& t_path)
+{
+	close();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(t_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0
+		? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+	const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	if (!view)
+	{
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = static_cast<const unsigned char*>(view);
+	m_size = static_cast<size_t>(size.QuadPart);
+#else
+	int file = ::open(t_path.c_str(), O_RDONLY);
+	if (file < 0) return false;
+
+	struct stat info;
+	void* view = (fstat(file, &info) == 0 && info.st_size > 0)
+		? mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+	::close(file); // the mapping keeps the file alive
+
+	if (view == MAP_FAILED) return false;
+
+	m_data = static_cast<const unsigned char*>(view);
+	m_size = static_cast<size_t>(info.st_size);
+#endif
+
+	if (!fixUp())
+	{
+		DEBUG_MSG("ERROR: Snapshot is malformed or from another version: " + t_path);
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Validates the header and turns block offsets into pointers
+/// </summary>
+bool SceneSnapshot::fixUp()
+{
+	if (m_size < sizeof(Header)) return false;
+
+	const Header* header = reinterpret_cast<const Header*>(m_data);
+
+	if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+		|| header->byteOrder != BYTE_ORDER_MARK
+		|| header->version != VERSION
+		|| header->headerSize != sizeof(Header)
+		|| header->blockCount != NUM_BLOCKS)
+	{
+		return false;
+	}
+
+	// In 64 bits so a huge count cannot wrap a 32-bit size_t into a small one
+	const uint64_t objects = header->objectCount;
+	const uint64_t meshes = header->meshCount;
+	const uint64_t vertices = header->vertexCount;
+	if (sizeof(float) * objects > m_size || sizeof(uint32_t) * meshes > m_size || sizeof(Vertex) * vertices > m_size)
+	{
+		return false;
+	}
+
+	const uint64_t expected[NUM_BLOCKS] = {
+		sizeof(float) * objects, sizeof(float) * objects, sizeof(float) * objects,
+		sizeof(uint32_t) * objects, sizeof(float) * objects,
+		sizeof(uint32_t) * meshes, sizeof(uint32_t) * meshes,
+		sizeof(Vertex) * vertices
+	};
+
+	const void* blocks[NUM_BLOCKS];
+	for (int i = 0; i < NUM_BLOCKS; i++)
+	{
+		const BlockEntry& block = header->blocks[i];
+
+		if (block.size != expected[i] || block.offset % BLOCK_ALIGNMENT != 0
+			|| block.offset > m_size || block.size > m_size - block.offset)
+		{
+			return false;
+		}
+
+		blocks[i] = m_data + block.offset;
+	}
+
+	m_state.objectCount = header->objectCount;
+	m_state.translationX = static_cast<const float*>(blocks[TRANSLATION_X]);
+	m_state.translationY = static_cast<const float*>(blocks[TRANSLATION_Y]);
+	m_state.translationZ = static_cast<const float*>(blocks[TRANSLATION_Z]);
+	m_state.mesh = static_cast<const uint32_t*>(blocks[OBJECT_MESH]);
+	m_state.animationTime = static_cast<const float*>(blocks[ANIMATION_TIME]);
+	m_state.meshCount = header->meshCount;
+	m_state.meshFirstVertex = static_cast<const uint32_t*>(blocks[MESH_FIRST_VERTEX]);
+	m_state.meshVertexCount = static_cast<const uint32_t*>(blocks[MESH_VERTEX_COUNT]);
+	m_state.vertexCount = header->vertexCount;
+	m_state.vertices = static_cast<const Vertex*>(blocks[VERTICES]);
+
+	// Mesh references must stay inside the vertex block
+	for (uint32_t i = 0; i < m_state.meshCount; i++)
+	{
+		if (m_state.meshFirstVertex[i] > m_state.vertexCount
+			|| m_state.meshVertexCount[i] > m_state.vertexCount - m_state.meshFirstVertex[i])
+		{
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < m_state.objectCount; i++)
+	{
+		if (m_state.mesh[i] >= m_state.meshCount) return false;
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+void SceneSnapshot::close()
+{
+	if (m_data)
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		m_mapping = m_file = nullptr;
+#else
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_state = SceneState();
+}
@@ -0,0 +1,70 @@
+#ifndef SCENE_SNAPSHOT_H
+#define SCENE_SNAPSHOT_H
+
+#include <Mesh.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Scene state in structure-of-arrays form. Passed to SceneSnapshot::save(),
+/// and returned by SceneSnapshot::open() with every pointer fixed up to
+/// point straight into the mapped file.
+/// </summary>
+struct SceneState
+{
+	uint32_t objectCount = 0;
+	const float* translationX = nullptr;
+	const float* translationY = nullptr;
+	const float* translationZ = nullptr;
+	const uint32_t* mesh = nullptr; // index into the mesh arrays
+	const float* animationTime = nullptr; // seconds
+
+	uint32_t meshCount = 0;
+	const uint32_t* meshFirstVertex = nullptr;
+	const uint32_t* meshVertexCount = nullptr;
+
+	uint32_t vertexCount = 0;
+	const Vertex* vertices = nullptr; // GPU layout, can be uploaded as is
+};
+
+/// <summary>
+/// Versioned scene snapshot file laid out for direct memory mapping.
+/// A fixed header lists the offset and size of each block; blocks are
+/// 16-byte aligned arrays in native byte order, so saving is a single
+/// write and loading is a map plus pointer fix-up, with no parsing.
+/// </summary>
+class SceneSnapshot
+{
+public:
+	static const uint32_t VERSION = 1;
+
+	SceneSnapshot();
+	~SceneSnapshot();
+	SceneSnapshot(const SceneSnapshot&) = delete;
+	SceneSnapshot& operator=(const SceneSnapshot&) = delete;
+
+	static bool save(const std::string& t_path, const SceneState& t_state);
+
+	bool open(const std::string& t_path);
+	void close();
+	bool isOpen() const { return m_data != nullptr; }
+
+	// Valid until close(); points into the mapping
+	const SceneState& getState() const { return m_state; }
+
+private:
+	bool fixUp();
+
+	const unsigned char* m_data;
+	size_t m_size;
+	SceneState m_state;
+
+#if defined(_WIN32)
+	void* m_file;
+	void* m_mapping;
+#endif
+};
+
+#endif
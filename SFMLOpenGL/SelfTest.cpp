@@ -0,0 +1,314 @@
+#include <SelfTest.h>
+#include <SoftwareRasterizer.h>
+#include <BufferAllocator.h>
+#include <Metrics.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <math.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Neither size is a multiple of the tile size or of four, so partial tiles and span remainders are covered
+	const unsigned RASTER_WIDTH = 203;
+	const unsigned RASTER_HEIGHT = 157;
+	const unsigned RASTER_FRAMES = 40;
+	const unsigned RASTER_THREADS[] = { 1, 2, 7, 16 };
+
+	// Small enough that the allocator fills up and fails regularly
+	const uint32_t ALLOCATOR_CAPACITY = 1 << 16;
+	const uint32_t ALLOCATOR_MAX_SIZE = 1024;
+	const unsigned ALLOCATOR_OPERATIONS = 200000;
+	const unsigned ALLOCATOR_SEED = 44;
+
+	// Frame times of 100, 200, ... 100000 microseconds, several landing exactly on a bucket bound
+	const unsigned METRICS_FRAMES = 1000;
+	const uint64_t METRICS_FRAME_STEP = 100;
+
+	// Same corners and triangles as Game's cube
+	const float CUBE_CORNERS[8][3] = {
+		{ -0.5f, 0.5f, 0.5f }, { -0.5f, -0.5f, 0.5f }, { 0.5f, 0.5f, 0.5f }, { 0.5f, -0.5f, 0.5f },
+		{ -0.5f, -0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }
+	};
+	const GLubyte CUBE_TRIANGLES[36] = {
+		1, 3, 0, 3, 2, 0, 5, 4, 0, 4, 1, 0, 7, 6, 3, 6, 2, 3,
+		6, 5, 2, 5, 0, 2, 5, 6, 4, 6, 7, 4, 4, 7, 1, 1, 7, 3
+	};
+
+	/// <summary>
+	/// Colour and depth of every frame rendered with one setting, back to back
+	/// </summary>
+	struct RasterRun
+	{
+		std::vector<uint32_t> color;
+		std::vector<float> depth;
+	};
+
+	/// <summary>
+	/// Renders RASTER_FRAMES fixed poses of two overlapping cubes, so depth
+	/// testing decides some pixels, with the camera orbiting and tilting
+	/// </summary>
+	RasterRun renderCubes(unsigned t_threads, bool t_simd)
+	{
+		Vertex cube[8];
+		std::memset(cube, 0, sizeof(cube));
+		for (int i = 0; i < 8; i++)
+		{
+			std::memcpy(cube[i].coordinate, CUBE_CORNERS[i], sizeof(CUBE_CORNERS[i]));
+		}
+
+		SoftwareRasterizer rasterizer(t_threads);
+		rasterizer.setSimd(t_simd);
+		rasterizer.resize(RASTER_WIDTH, RASTER_HEIGHT);
+
+		FrameData frame;
+		std::memset(&frame, 0, sizeof(frame));
+		FrameUniforms::perspective(45.0f, static_cast<float>(RASTER_WIDTH) / RASTER_HEIGHT, 1.0f, 500.0f, frame.projection);
+
+		RasterRun run;
+		const size_t pixels = static_cast<size_t>(RASTER_WIDTH) * RASTER_HEIGHT;
+
+		for (unsigned i = 0; i < RASTER_FRAMES; i++)
+		{
+			frame.time = i * 0.05f;
+			rasterizer.clear(0.1f, 0.2f, 0.3f, 1.0f);
+
+			FrameUniforms::view(i * 9.0f, 20.0f * sinf(i * 0.3f), 0.1f * i - 2.0f, 0.0f, -3.0f - 0.02f * i, frame.view);
+			rasterizer.draw(frame, cube, 8, CUBE_TRIANGLES, 36, GL_UNSIGNED_BYTE);
+
+			FrameUniforms::view(i * 9.0f, 20.0f * sinf(i * 0.3f), 0.1f * i - 1.6f, 0.3f, -3.4f - 0.02f * i, frame.view);
+			rasterizer.draw(frame, cube, 8, CUBE_TRIANGLES, 36, GL_UNSIGNED_BYTE);
+
+			rasterizer.finish();
+
+			run.color.insert(run.color.end(), rasterizer.getColor(), rasterizer.getColor() + pixels);
+			run.depth.insert(run.depth.end(), rasterizer.getDepth(), rasterizer.getDepth() + pixels);
+		}
+
+		return run;
+	}
+
+	/// <returns>number of frames whose colour or depth differ in any bit</returns>
+	size_t compareRuns(const RasterRun& t_left, const RasterRun& t_right)
+	{
+		const size_t pixels = static_cast<size_t>(RASTER_WIDTH) * RASTER_HEIGHT;
+		size_t differing = 0;
+
+		for (unsigned i = 0; i < RASTER_FRAMES; i++)
+		{
+			if (std::memcmp(&t_left.color[i * pixels], &t_right.color[i * pixels], pixels * sizeof(uint32_t)) != 0
+				|| std::memcmp(&t_left.depth[i * pixels], &t_right.depth[i * pixels], pixels * sizeof(float)) != 0)
+			{
+				differing++;
+			}
+		}
+
+		return differing;
+	}
+
+	void report(std::ostream& t_out, const std::string& t_name, const size_t t_failures, const size_t t_checked)
+	{
+		t_out << (t_failures == 0 ? "PASS " : "FAIL ") << t_name << ": " << t_failures << " of " << t_checked << " differ" << std::endl;
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// SoftwareRasterizer is the reference image, so its output must not depend
+/// on the thread count or on whether spans take the SSE2 path, down to the
+/// last bit of colour and depth. A cube seen face on, with the screen centre
+/// on a pixel centre, must also give known pixels and the analytic depth.
+/// </summary>
+bool SelfTest::rasterizer(std::ostream& t_out)
+{
+	const RasterRun reference = renderCubes(1, true);
+	bool passed = true;
+
+	for (unsigned threads : RASTER_THREADS)
+	{
+		if (threads == 1) continue;
+
+		const size_t differing = compareRuns(reference, renderCubes(threads, true));
+		report(t_out, "SoftwareRasterizer " + std::to_string(threads) + " threads against 1", differing, RASTER_FRAMES);
+		passed = passed && differing == 0;
+	}
+
+	const size_t scalarDiffering = compareRuns(reference, renderCubes(1, false));
+	report(t_out, "SoftwareRasterizer SSE2 spans against scalar", scalarDiffering, RASTER_FRAMES);
+	passed = passed && scalarDiffering == 0;
+
+	// Face on from 2.5 units at time 0.5, where every rainbow channel is far from a rounding step
+	Vertex cube[8];
+	std::memset(cube, 0, sizeof(cube));
+	for (int i = 0; i < 8; i++)
+	{
+		std::memcpy(cube[i].coordinate, CUBE_CORNERS[i], sizeof(CUBE_CORNERS[i]));
+	}
+
+	FrameData frame;
+	std::memset(&frame, 0, sizeof(frame));
+	frame.time = 0.5f;
+	FrameUniforms::perspective(45.0f, static_cast<float>(RASTER_WIDTH) / RASTER_HEIGHT, 1.0f, 500.0f, frame.projection);
+	FrameUniforms::view(0.0f, 0.0f, 0.0f, 0.0f, -3.0f, frame.view);
+
+	SoftwareRasterizer single(1);
+	single.resize(RASTER_WIDTH, RASTER_HEIGHT);
+	single.clear(0.0f, 0.0f, 0.0f, 0.0f);
+	single.draw(frame, cube, 8, CUBE_TRIANGLES, 36, GL_UNSIGNED_BYTE);
+	single.finish();
+
+	const size_t centre = static_cast<size_t>(RASTER_HEIGHT / 2) * RASTER_WIDTH + RASTER_WIDTH / 2;
+	const double expectedDepth = 300.0 / 499.0; // window depth of view distance 2.5 with near 1, far 500
+
+	size_t pixelFailures = 0;
+	if (single.getColor()[centre] != 0x80BFBF00) pixelFailures++; // RGBA 0, 191, 191, 128, R in the low byte
+	if (fabs(single.getDepth()[centre] - expectedDepth) > 1e-6) pixelFailures++;
+	if (single.getColor()[0] != 0 || single.getDepth()[0] != 1.0f) pixelFailures++; // corner keeps the clear
+	if (single.getStats().triangles != 12) pixelFailures++;
+
+	report(t_out, "SoftwareRasterizer known pixels", pixelFailures, 4);
+	passed = passed && pixelFailures == 0;
+
+	return passed;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Random allocate and free calls, sizes and power-of-two alignments against
+/// a shadow of the live ranges. Every range must lie inside the capacity, be
+/// aligned and overlap no other, used must be the sum of the live sizes, and
+/// freeing everything must merge the free list back into one range.
+/// </summary>
+bool SelfTest::bufferAllocator(std::ostream& t_out)
+{
+	BufferAllocator allocator(ALLOCATOR_CAPACITY);
+	std::map<uint32_t, uint32_t> live; // offset -> size
+	std::vector<uint32_t> offsets; // same keys, for picking one at random
+	uint32_t used = 0;
+
+	std::mt19937 random(ALLOCATOR_SEED);
+	size_t placementFailures = 0, accountingFailures = 0;
+
+	for (unsigned i = 0; i < ALLOCATOR_OPERATIONS; i++)
+	{
+		// Lean towards allocating while nearly empty and freeing while nearly full
+		const bool freeing = !offsets.empty() && random() % ALLOCATOR_CAPACITY < used + ALLOCATOR_CAPACITY / 4;
+
+		if (freeing)
+		{
+			const size_t pick = random() % offsets.size();
+			const uint32_t offset = offsets[pick];
+			offsets[pick] = offsets.back();
+			offsets.pop_back();
+
+			if (allocator.getSize(offset) != live[offset]) placementFailures++;
+			used -= live[offset];
+			live.erase(offset);
+			allocator.free(offset);
+		}
+		else
+		{
+			const uint32_t size = 1 + random() % ALLOCATOR_MAX_SIZE;
+			const uint32_t alignment = 1u << (random() % 9);
+			const uint32_t largestFree = allocator.getStats().largestFree;
+			const uint32_t offset = allocator.allocate(size, alignment);
+
+			if (offset == BufferAllocator::INVALID)
+			{
+				// Without alignment padding, anything up to the largest free range must fit
+				if (alignment == 1 && size <= largestFree) placementFailures++;
+			}
+			else
+			{
+				std::map<uint32_t, uint32_t>::iterator next = live.lower_bound(offset);
+				const bool overlapsNext = next != live.end() && next->first < offset + size;
+				const bool overlapsPrevious = next != live.begin() && std::prev(next)->first + std::prev(next)->second > offset;
+
+				if (offset % alignment != 0 || offset + size > ALLOCATOR_CAPACITY || overlapsNext || overlapsPrevious
+					|| allocator.getSize(offset) != size)
+				{
+					placementFailures++;
+				}
+
+				live[offset] = size;
+				offsets.push_back(offset);
+				used += size;
+			}
+		}
+
+		const BufferAllocatorStats stats = allocator.getStats();
+		if (stats.used != used || stats.allocations != live.size()) accountingFailures++;
+	}
+
+	report(t_out, "BufferAllocator placement", placementFailures, ALLOCATOR_OPERATIONS);
+	report(t_out, "BufferAllocator used and allocation count", accountingFailures, ALLOCATOR_OPERATIONS);
+
+	for (uint32_t offset : offsets)
+	{
+		allocator.free(offset);
+	}
+
+	const BufferAllocatorStats empty = allocator.getStats();
+	size_t coalesceFailures = 0;
+	if (empty.used != 0 || empty.allocations != 0) coalesceFailures++;
+	if (empty.freeBlocks != 1 || empty.largestFree != ALLOCATOR_CAPACITY) coalesceFailures++;
+
+	report(t_out, "BufferAllocator coalesces once empty", coalesceFailures, 2);
+
+	return placementFailures == 0 && accountingFailures == 0 && coalesceFailures == 0;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// The exported le counts must be exact on frame times evenly spread up to
+/// 100 ms, including those that fall exactly on a bound, both from the getter
+/// and in the Prometheus text.
+/// </summary>
+bool SelfTest::metrics(std::ostream& t_out)
+{
+	Metrics metrics;
+	for (unsigned i = 1; i <= METRICS_FRAMES; i++)
+	{
+		metrics.recordFrameTime(i * METRICS_FRAME_STEP);
+	}
+
+	const std::string text = metrics.toPrometheus();
+	size_t failures = 0;
+
+	for (int i = 0; i < Metrics::FRAME_TIME_BUCKET_COUNT; i++)
+	{
+		const uint64_t expected = std::min<uint64_t>(METRICS_FRAMES, Metrics::FRAME_TIME_BUCKETS[i] / METRICS_FRAME_STEP);
+
+		char line[128];
+		snprintf(line, sizeof(line), "gpp_frame_time_seconds_bucket{le=\"%g\"} %llu\n",
+			Metrics::FRAME_TIME_BUCKETS[i] / 1e6, static_cast<unsigned long long>(expected));
+
+		if (metrics.getFrameTimeAtOrBelow(i) != expected || text.find(line) == std::string::npos) failures++;
+	}
+
+	report(t_out, "Metrics frame time bucket counts", failures, Metrics::FRAME_TIME_BUCKET_COUNT);
+
+	return failures == 0;
+}
+
+/////////////////////////////////////////////////////////
+
+bool SelfTest::run(std::ostream& t_out)
+{
+	bool passed = true;
+
+	passed = rasterizer(t_out) && passed;
+	passed = bufferAllocator(t_out) && passed;
+	passed = metrics(t_out) && passed;
+
+	return passed;
+}
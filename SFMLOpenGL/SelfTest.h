@@ -0,0 +1,21 @@
+#ifndef SELF_TEST_H
+#define SELF_TEST_H
+
+#include <ostream>
+
+/// <summary>
+/// Checks of the CPU-side engine code that needs no window or GL context,
+/// alongside gpp::MathSelfTest. Each check prints one PASS or FAIL line per
+/// property and returns true if all held. Run with --selftest.
+/// </summary>
+class SelfTest
+{
+public:
+	static bool rasterizer(std::ostream& t_out);
+	static bool bufferAllocator(std::ostream& t_out);
+	static bool metrics(std::ostream& t_out);
+
+	static bool run(std::ostream& t_out);
+};
+
+#endif
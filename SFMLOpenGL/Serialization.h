@@ -0,0 +1,80 @@
+#ifndef MY_SERIALIZATION
+#define MY_SERIALIZATION
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <cstddef>
+
+namespace gpp
+{
+	namespace Binary
+	{
+		/// <summary>
+		/// Writes a float as 4 little-endian bytes, independent of host byte order
+		/// </summary>
+		inline unsigned char* writeFloat(unsigned char* t_dst, const float t_value)
+		{
+			std::uint32_t bits;
+			std::memcpy(&bits, &t_value, sizeof(bits));
+
+			t_dst[0] = static_cast<unsigned char>(bits);
+			t_dst[1] = static_cast<unsigned char>(bits >> 8);
+			t_dst[2] = static_cast<unsigned char>(bits >> 16);
+			t_dst[3] = static_cast<unsigned char>(bits >> 24);
+
+			return t_dst + 4;
+		}
+
+		/// <summary>
+		/// Reads a float written by writeFloat
+		/// </summary>
+		inline const unsigned char* readFloat(const unsigned char* t_src, float& t_value)
+		{
+			std::uint32_t bits = static_cast<std::uint32_t>(t_src[0])
+				| (static_cast<std::uint32_t>(t_src[1]) << 8)
+				| (static_cast<std::uint32_t>(t_src[2]) << 16)
+				| (static_cast<std::uint32_t>(t_src[3]) << 24);
+
+			std::memcpy(&t_value, &bits, sizeof(bits));
+
+			return t_src + 4;
+		}
+	}
+
+	namespace Text
+	{
+		/// <summary>
+		/// Appends a character if it fits before t_end
+		/// </summary>
+		inline bool append(char*& t_cursor, char* t_end, const char t_char)
+		{
+			if (t_cursor >= t_end) return false;
+			*t_cursor++ = t_char;
+			return true;
+		}
+
+		/// <summary>
+		/// Appends the shortest round-trip representation of a float, if it fits
+		/// </summary>
+		inline bool append(char*& t_cursor, char* t_end, const float t_value)
+		{
+			std::to_chars_result result = std::to_chars(t_cursor, t_end, t_value);
+			if (result.ec != std::errc()) return false;
+			t_cursor = result.ptr;
+			return true;
+		}
+
+		/// <summary>
+		/// Appends a null-terminated string, if it fits
+		/// </summary>
+		inline bool append(char*& t_cursor, char* t_end, const char* t_text)
+		{
+			while (*t_text)
+			{
+				if (!append(t_cursor, t_end, *t_text++)) return false;
+			}
+			return true;
+		}
+	}
+}
+#endif // !MY_SERIALIZATION
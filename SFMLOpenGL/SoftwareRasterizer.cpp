@@ -0,0 +1,502 @@
+#include <SoftwareRasterizer.h>
+#include <Trace.h>
+
+#include <algorithm>
+#include <math.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// Must match frag_shader.phil
+	const float RAINBOW_PHASE[3] = { 240.0f, 120.0f, 0.0f };
+	const float RAINBOW_SPEED = 60.0f;
+	const float RAINBOW_ALPHA = 0.5f;
+
+	uint32_t packColor(float t_r, float t_g, float t_b, float t_a)
+	{
+		const float channels[4] = { t_r, t_g, t_b, t_a };
+		uint32_t packed = 0;
+
+		for (int i = 0; i < 4; i++)
+		{
+			float c = std::min(std::max(channels[i], 0.0f), 1.0f);
+			packed |= static_cast<uint32_t>(c * 255.0f + 0.5f) << (8 * i); // R in the lowest byte
+		}
+
+		return packed;
+	}
+
+	unsigned readIndex(const void* t_indices, GLenum t_indexType, size_t t_i)
+	{
+		if (t_indexType == GL_UNSIGNED_INT) return static_cast<const GLuint*>(t_indices)[t_i];
+		if (t_indexType == GL_UNSIGNED_SHORT) return static_cast<const GLushort*>(t_indices)[t_i];
+		return static_cast<const GLubyte*>(t_indices)[t_i];
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+SoftwareRasterizer::SoftwareRasterizer(unsigned t_threads) :
+	m_width{ 0 },
+	m_height{ 0 },
+	m_tilesX{ 0 },
+	m_tilesY{ 0 },
+	m_culling{ true },
+	m_depthTest{ true },
+	m_simd{ true },
+	m_clearPending{ false },
+	m_clearColor{ 0 },
+	m_generation{ 0 },
+	m_busy{ 0 },
+	m_stopping{ false },
+	m_nextTile{ 0 }
+{
+	unsigned threads = t_threads ? t_threads : std::max(1u, std::thread::hardware_concurrency());
+
+	// The thread calling finish() works too
+	for (unsigned i = 1; i < threads; i++)
+	{
+		m_workers.emplace_back(&SoftwareRasterizer::workerLoop, this);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_start.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Reallocates the colour and depth targets; their contents are undefined until clear()
+/// </summary>
+void SoftwareRasterizer::resize(unsigned t_width, unsigned t_height)
+{
+	m_width = t_width;
+	m_height = t_height;
+	m_tilesX = (t_width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tilesY = (t_height + TILE_SIZE - 1) / TILE_SIZE;
+
+	m_color.assign(static_cast<size_t>(t_width) * t_height, 0);
+	m_depth.assign(static_cast<size_t>(t_width) * t_height, 1.0f);
+	m_bins.assign(m_tilesX * m_tilesY, std::vector<uint32_t>());
+	m_triangles.clear();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Clears colour to the given value and depth to 1. The clear is deferred to
+/// finish(), where each tile clears itself before rasterizing.
+/// </summary>
+void SoftwareRasterizer::clear(float t_r, float t_g, float t_b, float t_a)
+{
+	m_clearColor = packColor(t_r, t_g, t_b, t_a);
+	m_clearPending = true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Runs the vertex stage and bins the resulting triangles, as glDrawElements(GL_TRIANGLES) would
+/// </summary>
+/// <param name="t_frame">view, projection and time, as uploaded to FrameData</param>
+/// <param name="t_vertices">vertex data; only positions are used</param>
+/// <param name="t_numVertices">number of vertices</param>
+/// <param name="t_indices">index data</param>
+/// <param name="t_numIndices">number of indices, three per triangle</param>
+/// <param name="t_indexType">GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT</param>
+void SoftwareRasterizer::draw(const FrameData& t_frame, const Vertex* t_vertices, size_t t_numVertices,
+	const void* t_indices, size_t t_numIndices, GLenum t_indexType)
+{
+	// Fragment stage: the colour is uniform across the draw
+	float rainbow[3];
+	for (int i = 0; i < 3; i++)
+	{
+		rainbow[i] = (1.0f + sinf((RAINBOW_PHASE[i] + t_frame.time * RAINBOW_SPEED) * 3.14159265f / 180.0f)) / 2.0f;
+	}
+	const uint32_t color = packColor(rainbow[0], rainbow[1], rainbow[2], RAINBOW_ALPHA);
+
+	// Vertex stage: clip = projection * view * position
+	float matrix[16];
+	FrameUniforms::multiply(t_frame.projection, t_frame.view, matrix);
+
+	for (size_t i = 0; i + 2 < t_numIndices; i += 3)
+	{
+		m_stats.triangles++;
+
+		float clip[3][4];
+		bool valid = true;
+
+		for (int v = 0; v < 3; v++)
+		{
+			unsigned index = readIndex(t_indices, t_indexType, i + v);
+			if (index >= t_numVertices)
+			{
+				valid = false;
+				break;
+			}
+
+			const float* p = t_vertices[index].coordinate;
+			for (int row = 0; row < 4; row++)
+			{
+				clip[v][row] = matrix[row] * p[0] + matrix[4 + row] * p[1] + matrix[8 + row] * p[2] + matrix[12 + row];
+			}
+		}
+
+		if (!valid)
+		{
+			m_stats.culled++;
+			continue;
+		}
+
+		// Clip against the near plane, z >= -w, leaving a polygon of up to four vertices
+		float polygon[4][4];
+		int count = 0;
+
+		for (int v = 0; v < 3; v++)
+		{
+			const float* a = clip[v];
+			const float* b = clip[(v + 1) % 3];
+			const float da = a[2] + a[3];
+			const float db = b[2] + b[3];
+
+			if (da >= 0.0f)
+			{
+				std::copy(a, a + 4, polygon[count++]);
+			}
+			if ((da >= 0.0f) != (db >= 0.0f))
+			{
+				const float t = da / (da - db);
+				for (int k = 0; k < 4; k++)
+				{
+					polygon[count][k] = a[k] + (b[k] - a[k]) * t;
+				}
+				count++;
+			}
+		}
+
+		if (count < 3)
+		{
+			m_stats.culled++;
+			continue;
+		}
+
+		// Perspective divide and viewport transform
+		float window[4][3];
+		for (int v = 0; v < count; v++)
+		{
+			const float w = polygon[v][3];
+			window[v][0] = (polygon[v][0] / w * 0.5f + 0.5f) * m_width;
+			window[v][1] = (polygon[v][1] / w * 0.5f + 0.5f) * m_height;
+			window[v][2] = polygon[v][2] / w * 0.5f + 0.5f;
+		}
+
+		// Fan out the clipped polygon
+		bool binned = false;
+		for (int v = 1; v + 1 < count; v++)
+		{
+			const float triangle[3][3] = {
+				{ window[0][0], window[0][1], window[0][2] },
+				{ window[v][0], window[v][1], window[v][2] },
+				{ window[v + 1][0], window[v + 1][1], window[v + 1][2] }
+			};
+			binned = setup(triangle, color) || binned;
+		}
+
+		if (!binned)
+		{
+			m_stats.culled++;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Culls one window-space triangle, computes its edge functions and depth plane, and bins it
+/// </summary>
+/// <returns>false if the triangle was culled</returns>
+bool SoftwareRasterizer::setup(const float t_window[3][3], uint32_t t_color)
+{
+	const float* v[3] = { t_window[0], t_window[1], t_window[2] };
+
+	// Positive area is counter-clockwise, GL's default front face
+	float area = (v[1][0] - v[0][0]) * (v[2][1] - v[0][1]) - (v[2][0] - v[0][0]) * (v[1][1] - v[0][1]);
+
+	if (area == 0.0f || (m_culling && area < 0.0f))
+	{
+		return false;
+	}
+	if (area < 0.0f)
+	{
+		std::swap(v[1], v[2]);
+		area = -area;
+	}
+
+	Triangle triangle;
+	triangle.color = t_color;
+	triangle.za = triangle.zb = triangle.zc = 0.0f;
+
+	// Edge i runs between the two vertices other than i and is zero at them
+	for (int i = 0; i < 3; i++)
+	{
+		const float* a = v[(i + 1) % 3];
+		const float* b = v[(i + 2) % 3];
+
+		triangle.a[i] = a[1] - b[1];
+		triangle.b[i] = b[0] - a[0];
+		triangle.c[i] = a[0] * b[1] - a[1] * b[0];
+		triangle.topLeft[i] = triangle.a[i] > 0.0f || (triangle.a[i] == 0.0f && triangle.b[i] < 0.0f);
+
+		// Barycentric weight of vertex i is edge i / area
+		triangle.za += triangle.a[i] * v[i][2] / area;
+		triangle.zb += triangle.b[i] * v[i][2] / area;
+		triangle.zc += triangle.c[i] * v[i][2] / area;
+	}
+
+	// Pixels whose centres fall inside the bounding box
+	const float minX = std::min(std::min(v[0][0], v[1][0]), v[2][0]);
+	const float maxX = std::max(std::max(v[0][0], v[1][0]), v[2][0]);
+	const float minY = std::min(std::min(v[0][1], v[1][1]), v[2][1]);
+	const float maxY = std::max(std::max(v[0][1], v[1][1]), v[2][1]);
+
+	triangle.minX = std::max(0, static_cast<int>(ceilf(minX - 0.5f)));
+	triangle.minY = std::max(0, static_cast<int>(ceilf(minY - 0.5f)));
+	triangle.maxX = std::min(static_cast<int>(m_width) - 1, static_cast<int>(floorf(maxX - 0.5f)));
+	triangle.maxY = std::min(static_cast<int>(m_height) - 1, static_cast<int>(floorf(maxY - 0.5f)));
+
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+	{
+		return false;
+	}
+
+	const uint32_t index = static_cast<uint32_t>(m_triangles.size());
+	m_triangles.push_back(triangle);
+
+	for (int ty = triangle.minY / TILE_SIZE; ty <= triangle.maxY / TILE_SIZE; ty++)
+	{
+		for (int tx = triangle.minX / TILE_SIZE; tx <= triangle.maxX / TILE_SIZE; tx++)
+		{
+			m_bins[ty * m_tilesX + tx].push_back(index);
+			m_stats.binned++;
+		}
+	}
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Rasterizes everything drawn since the last finish() and waits for it
+/// </summary>
+void SoftwareRasterizer::finish()
+{
+	m_nextTile = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_generation++;
+		m_busy = static_cast<unsigned>(m_workers.size());
+	}
+	m_start.notify_all();
+
+	rasterizeTiles();
+
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_busy == 0; });
+	}
+
+	for (std::vector<uint32_t>& bin : m_bins)
+	{
+		bin.clear();
+	}
+	m_triangles.clear();
+	m_clearPending = false;
+
+	m_lastStats = m_stats;
+	m_stats = RasterStats();
+}
+
+/////////////////////////////////////////////////////////
+
+void SoftwareRasterizer::workerLoop()
+{
+	TRACE_THREAD_NAME("raster worker");
+	unsigned generation = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_start.wait(lock, [&] { return m_stopping || m_generation != generation; });
+			if (m_stopping) return;
+			generation = m_generation;
+		}
+
+		rasterizeTiles();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_busy--;
+		}
+		m_done.notify_one();
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Takes tiles from the shared counter until none are left
+/// </summary>
+void SoftwareRasterizer::rasterizeTiles()
+{
+	TRACE_SCOPE("SoftwareRasterizer::rasterizeTiles", "job");
+
+	const unsigned numTiles = m_tilesX * m_tilesY;
+
+	for (unsigned tile = m_nextTile++; tile < numTiles; tile = m_nextTile++)
+	{
+		rasterizeTile(tile);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+void SoftwareRasterizer::rasterizeTile(unsigned t_tile)
+{
+	const int tileX0 = (t_tile % m_tilesX) * TILE_SIZE;
+	const int tileY0 = (t_tile / m_tilesX) * TILE_SIZE;
+	const int tileX1 = std::min(tileX0 + TILE_SIZE, static_cast<int>(m_width)) - 1;
+	const int tileY1 = std::min(tileY0 + TILE_SIZE, static_cast<int>(m_height)) - 1;
+
+	if (m_clearPending)
+	{
+		for (int y = tileY0; y <= tileY1; y++)
+		{
+			const size_t row = static_cast<size_t>(y) * m_width;
+			std::fill(m_color.begin() + row + tileX0, m_color.begin() + row + tileX1 + 1, m_clearColor);
+			std::fill(m_depth.begin() + row + tileX0, m_depth.begin() + row + tileX1 + 1, 1.0f);
+		}
+	}
+
+	for (uint32_t index : m_bins[t_tile])
+	{
+		const Triangle& tri = m_triangles[index];
+
+		const int x0 = std::max(tri.minX, tileX0);
+		const int x1 = std::min(tri.maxX, tileX1);
+		const int y0 = std::max(tri.minY, tileY0);
+		const int y1 = std::min(tri.maxY, tileY1);
+
+#ifdef RASTER_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+		const __m128i color = _mm_set1_epi32(static_cast<int>(tri.color));
+		__m128 a[3], topLeft[3];
+		for (int e = 0; e < 3; e++)
+		{
+			a[e] = _mm_set1_ps(tri.a[e]);
+			topLeft[e] = _mm_castsi128_ps(_mm_set1_epi32(tri.topLeft[e] ? -1 : 0));
+		}
+		const __m128 za = _mm_set1_ps(tri.za);
+#endif
+
+		for (int y = y0; y <= y1; y++)
+		{
+			const float py = static_cast<float>(y) + 0.5f;
+			const float rowEdge[3] = {
+				tri.b[0] * py + tri.c[0],
+				tri.b[1] * py + tri.c[1],
+				tri.b[2] * py + tri.c[2]
+			};
+			const float rowDepth = tri.zb * py + tri.zc;
+
+			uint32_t* colorRow = &m_color[static_cast<size_t>(y) * m_width];
+			float* depthRow = &m_depth[static_cast<size_t>(y) * m_width];
+
+			int x = x0;
+
+#ifdef RASTER_SSE2
+			__m128 edgeRow[3];
+			for (int e = 0; e < 3; e++)
+			{
+				edgeRow[e] = _mm_set1_ps(rowEdge[e]);
+			}
+			const __m128 depthRowValue = _mm_set1_ps(rowDepth);
+
+			for (; m_simd && x + 3 <= x1; x += 4)
+			{
+				const __m128 px = _mm_add_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), lanes)), half);
+
+				__m128 mask = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (int e = 0; e < 3; e++)
+				{
+					const __m128 edge = _mm_add_ps(_mm_mul_ps(a[e], px), edgeRow[e]);
+					const __m128 inside = _mm_or_ps(_mm_cmpgt_ps(edge, zero), _mm_and_ps(_mm_cmpeq_ps(edge, zero), topLeft[e]));
+					mask = _mm_and_ps(mask, inside);
+				}
+
+				// Fragments beyond the far plane are discarded, standing in for far clipping
+				const __m128 z = _mm_add_ps(_mm_mul_ps(za, px), depthRowValue);
+				mask = _mm_and_ps(mask, _mm_cmple_ps(z, one));
+
+				if (m_depthTest)
+				{
+					const __m128 depth = _mm_loadu_ps(depthRow + x);
+					mask = _mm_and_ps(mask, _mm_cmplt_ps(z, depth));
+					_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, depth)));
+				}
+
+				const __m128i maski = _mm_castps_si128(mask);
+				const __m128i dest = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colorRow + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(colorRow + x),
+					_mm_or_si128(_mm_and_si128(maski, color), _mm_andnot_si128(maski, dest)));
+			}
+#endif
+
+			// Remainder of the span, or all of it without SSE2
+			for (; x <= x1; x++)
+			{
+				const float px = static_cast<float>(x) + 0.5f;
+
+				bool inside = true;
+				for (int e = 0; e < 3; e++)
+				{
+					const float edge = tri.a[e] * px + rowEdge[e];
+					inside = inside && (edge > 0.0f || (edge == 0.0f && tri.topLeft[e]));
+				}
+
+				const float z = tri.za * px + rowDepth;
+				if (!inside || !(z <= 1.0f)) continue;
+
+				if (m_depthTest)
+				{
+					if (!(z < depthRow[x])) continue;
+					depthRow[x] = z;
+				}
+
+				colorRow[x] = tri.color;
+			}
+		}
+	}
+}
@@ -0,0 +1,112 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <Mesh.h>
+#include <FrameUniforms.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Counts from the last finish()
+/// </summary>
+struct RasterStats
+{
+	unsigned triangles = 0; // submitted
+	unsigned culled = 0; // back-facing, behind the near plane or off screen
+	unsigned binned = 0; // triangle-tile pairs rasterized
+};
+
+/// <summary>
+/// CPU implementation of the cube pipeline, for hosts without a usable GPU
+/// and as a driver-independent reference. It follows the same semantics as
+/// vert_shader/frag_shader: positions are transformed by projection * view,
+/// every fragment gets the uniform rainbow colour with alpha 0.5.
+///
+/// draw() transforms, clips against the near plane, culls and bins triangles
+/// into TILE_SIZE screen tiles; finish() rasterizes the tiles in parallel on a
+/// persistent pool of threads, four pixels at a time with SSE2 edge functions.
+/// Each tile belongs to one thread and keeps submission order, so the output
+/// is identical for any thread count. Rows are stored bottom-up in RGBA8, as
+/// glReadPixels returns them.
+/// </summary>
+class SoftwareRasterizer
+{
+public:
+	static const int TILE_SIZE = 64;
+
+	explicit SoftwareRasterizer(unsigned t_threads = 0); // 0 uses every core
+	~SoftwareRasterizer();
+	SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+	SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+	void resize(unsigned t_width, unsigned t_height);
+
+	// Match glEnable(GL_CULL_FACE) with the default back face / CCW front, and GL_DEPTH_TEST with GL_LESS
+	void setCulling(bool t_enabled) { m_culling = t_enabled; }
+	void setDepthTest(bool t_enabled) { m_depthTest = t_enabled; }
+
+	// false runs every span through the scalar loop, so the two can be checked against each other
+	void setSimd(bool t_enabled) { m_simd = t_enabled; }
+
+	void clear(float t_r, float t_g, float t_b, float t_a);
+	void draw(const FrameData& t_frame, const Vertex* t_vertices, size_t t_numVertices,
+		const void* t_indices, size_t t_numIndices, GLenum t_indexType);
+	void finish();
+
+	unsigned getWidth() const { return m_width; }
+	unsigned getHeight() const { return m_height; }
+	const uint32_t* getColor() const { return m_color.data(); }
+	const float* getDepth() const { return m_depth.data(); }
+	const RasterStats& getStats() const { return m_lastStats; }
+
+private:
+	/// <summary>
+	/// Edge functions and depth plane of one screen-space triangle. A pixel
+	/// centre (x, y) is inside when every edge a * x + b * y + c is positive,
+	/// or zero on a top-left edge.
+	/// </summary>
+	struct Triangle
+	{
+		float a[3], b[3], c[3];
+		bool topLeft[3];
+		float za, zb, zc; // window depth = za * x + zb * y + zc
+		int minX, minY, maxX, maxY; // inclusive pixel bounds, clipped to the target
+		uint32_t color;
+	};
+
+	bool setup(const float t_window[3][3], uint32_t t_color);
+	void rasterizeTiles();
+	void rasterizeTile(unsigned t_tile);
+	void workerLoop();
+
+	unsigned m_width, m_height;
+	unsigned m_tilesX, m_tilesY;
+	std::vector<uint32_t> m_color;
+	std::vector<float> m_depth;
+
+	bool m_culling, m_depthTest, m_simd;
+	bool m_clearPending;
+	uint32_t m_clearColor;
+
+	std::vector<Triangle> m_triangles;
+	std::vector<std::vector<uint32_t>> m_bins; // triangle indices per tile, in submission order
+	RasterStats m_stats; // accumulating until finish()
+	RasterStats m_lastStats;
+
+	// Thread pool, woken once per finish()
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_start, m_done;
+	unsigned m_generation;
+	unsigned m_busy;
+	bool m_stopping;
+	std::atomic<unsigned> m_nextTile;
+};
+
+#endif
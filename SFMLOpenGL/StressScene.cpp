@@ -0,0 +1,368 @@
+#include <StressScene.h>
+#include <Debug.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <random>
+
+const double StressScene::KNEE_GROWTH{ 0.25 };
+
+namespace
+{
+	const float PI = 3.14159265f;
+	const unsigned CLUSTER_SIZE = 64; // average objects per cluster
+	const float MAX_SPIN = 2.0f; // radians per second
+
+	/// <summary>
+	/// Interpolates a + (b - a) * u + (c - a) * v, position and colour
+	/// </summary>
+	Vertex blend(const Vertex& t_a, const Vertex& t_b, const Vertex& t_c, float t_u, float t_v)
+	{
+		Vertex result;
+		for (int i = 0; i < 3; i++)
+		{
+			result.coordinate[i] = t_a.coordinate[i] + (t_b.coordinate[i] - t_a.coordinate[i]) * t_u + (t_c.coordinate[i] - t_a.coordinate[i]) * t_v;
+		}
+		for (int i = 0; i < 4; i++)
+		{
+			result.color[i] = t_a.color[i] + (t_b.color[i] - t_a.color[i]) * t_u + (t_c.color[i] - t_a.color[i]) * t_v;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Appends an index as t_type, which must be GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	/// </summary>
+	void appendIndex(std::vector<unsigned char>& t_indices, GLenum t_type, uint32_t t_index)
+	{
+		if (t_type == GL_UNSIGNED_SHORT)
+		{
+			const uint16_t value = static_cast<uint16_t>(t_index);
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+			t_indices.insert(t_indices.end(), bytes, bytes + sizeof(value));
+		}
+		else
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&t_index);
+			t_indices.insert(t_indices.end(), bytes, bytes + sizeof(t_index));
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Reads "grid", "random" or "clustered"
+/// </summary>
+/// <returns>false, leaving t_distribution alone, for anything else</returns>
+bool StressScene::parseDistribution(const std::string& t_name, StressDistribution& t_distribution)
+{
+	if (t_name == "grid") t_distribution = GRID_DISTRIBUTION;
+	else if (t_name == "random") t_distribution = RANDOM_DISTRIBUTION;
+	else if (t_name == "clustered") t_distribution = CLUSTERED_DISTRIBUTION;
+	else return false;
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Builds a mesh from a vertex array and triangle list such as the cube's.
+/// Complexity 1 copies it as is. Higher complexities give every triangle its
+/// own vertices and split it into complexity^2 triangles along a lattice,
+/// wound the same way as the original.
+/// </summary>
+/// <param name="t_corners">vertices referenced by t_triangles</param>
+/// <param name="t_triangles">three indices per triangle</param>
+/// <param name="t_numTriangles">triangles in t_triangles</param>
+/// <param name="t_complexity">splits along each edge, at least 1</param>
+/// <param name="t_mesh">replaced; 16-bit indices where they fit, 32-bit otherwise</param>
+void StressScene::buildMesh(const Vertex* t_corners, const GLubyte* t_triangles, int t_numTriangles, unsigned t_complexity, MeshData& t_mesh)
+{
+	const uint32_t n = std::max(1u, t_complexity);
+
+	t_mesh.vertices.clear();
+	t_mesh.indices.clear();
+
+	if (n == 1)
+	{
+		const int numCorners = *std::max_element(t_triangles, t_triangles + 3 * t_numTriangles) + 1;
+
+		t_mesh.vertices.assign(t_corners, t_corners + numCorners);
+		t_mesh.indexType = GL_UNSIGNED_SHORT;
+		for (int i = 0; i < 3 * t_numTriangles; i++)
+		{
+			appendIndex(t_mesh.indices, t_mesh.indexType, t_triangles[i]);
+		}
+		t_mesh.numIndices = 3 * t_numTriangles;
+		return;
+	}
+
+	// Lattice point (i, j), i + j <= n, of one triangle; rows of shrinking length
+	const uint32_t perTriangle = (n + 1) * (n + 2) / 2;
+	auto lattice = [n](uint32_t t_i, uint32_t t_j) { return t_j * (n + 1) - t_j * (t_j - 1) / 2 + t_i; };
+
+	const size_t numVertices = static_cast<size_t>(perTriangle) * t_numTriangles;
+	t_mesh.indexType = numVertices <= 0xFFFF ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	t_mesh.vertices.reserve(numVertices);
+	t_mesh.numIndices = 0;
+
+	for (int t = 0; t < t_numTriangles; t++)
+	{
+		const Vertex& a = t_corners[t_triangles[3 * t]];
+		const Vertex& b = t_corners[t_triangles[3 * t + 1]];
+		const Vertex& c = t_corners[t_triangles[3 * t + 2]];
+		const uint32_t first = static_cast<uint32_t>(t_mesh.vertices.size());
+
+		for (uint32_t j = 0; j <= n; j++)
+		{
+			for (uint32_t i = 0; i + j <= n; i++)
+			{
+				t_mesh.vertices.push_back(blend(a, b, c, static_cast<float>(i) / n, static_cast<float>(j) / n));
+			}
+		}
+
+		for (uint32_t j = 0; j < n; j++)
+		{
+			for (uint32_t i = 0; i + j < n; i++)
+			{
+				// Same orientation as (a, b, c): u, then v, around the cell
+				appendIndex(t_mesh.indices, t_mesh.indexType, first + lattice(i, j));
+				appendIndex(t_mesh.indices, t_mesh.indexType, first + lattice(i + 1, j));
+				appendIndex(t_mesh.indices, t_mesh.indexType, first + lattice(i, j + 1));
+				t_mesh.numIndices += 3;
+
+				if (i + j + 1 < n)
+				{
+					appendIndex(t_mesh.indices, t_mesh.indexType, first + lattice(i + 1, j));
+					appendIndex(t_mesh.indices, t_mesh.indexType, first + lattice(i + 1, j + 1));
+					appendIndex(t_mesh.indices, t_mesh.indexType, first + lattice(i, j + 1));
+					t_mesh.numIndices += 3;
+				}
+			}
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Places t_objects objects, the same way for the same parameters. The
+/// field fills a cube sized so the average spacing matches t_params.spacing;
+/// occluders are flat walls across its front half, facing +z.
+/// </summary>
+void StressScene::generate(const StressParams& t_params, unsigned t_objects)
+{
+	std::mt19937 random(t_params.seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	const unsigned side = std::max(1u, static_cast<unsigned>(ceilf(cbrtf(static_cast<float>(t_objects)))));
+	m_extent = 0.5f * side * t_params.spacing;
+
+	const unsigned numOccluders = std::min(t_objects, static_cast<unsigned>(t_objects * t_params.occluderFraction + 0.5f));
+	const unsigned numAnimated = static_cast<unsigned>((t_objects - numOccluders) * t_params.animatedFraction + 0.5f);
+
+	// Cluster centres first, so each object can pick one
+	std::vector<float> clusters;
+	if (t_params.distribution == CLUSTERED_DISTRIBUTION)
+	{
+		const unsigned numClusters = std::max(1u, t_objects / CLUSTER_SIZE);
+		for (unsigned i = 0; i < 3 * numClusters; i++)
+		{
+			clusters.push_back((unit(random) * 2.0f - 1.0f) * m_extent);
+		}
+	}
+	std::normal_distribution<float> scatter(0.0f, t_params.spacing);
+
+	m_objects.resize(t_objects);
+	m_drawData.resize(t_objects);
+	m_bounds.resize(t_objects);
+	m_animated.clear();
+
+	for (unsigned i = 0; i < t_objects; i++)
+	{
+		StressObject& object = m_objects[i];
+		object.occluder = i < numOccluders;
+		object.phase = unit(random) * 2.0f * PI;
+		object.spin = 0.0f;
+
+		if (object.occluder)
+		{
+			// Walls a fifth of the field across, between the middle and the front
+			const float size = 0.4f * m_extent;
+			object.scale[0] = size;
+			object.scale[1] = size;
+			object.scale[2] = 0.25f;
+			object.position[0] = (unit(random) * 2.0f - 1.0f) * (m_extent - 0.5f * size);
+			object.position[1] = (unit(random) * 2.0f - 1.0f) * (m_extent - 0.5f * size);
+			object.position[2] = (0.5f + 0.5f * unit(random)) * m_extent;
+			object.phase = 0.0f;
+		}
+		else
+		{
+			object.scale[0] = object.scale[1] = object.scale[2] = 1.0f;
+
+			switch (t_params.distribution)
+			{
+			case GRID_DISTRIBUTION:
+			{
+				const unsigned cell = i - numOccluders;
+				const unsigned coordinates[3] = { cell % side, (cell / side) % side, cell / (side * side) };
+				for (int axis = 0; axis < 3; axis++)
+				{
+					object.position[axis] = (coordinates[axis] + 0.5f) * t_params.spacing - m_extent;
+				}
+				break;
+			}
+			case CLUSTERED_DISTRIBUTION:
+			{
+				const size_t cluster = 3 * (random() % (clusters.size() / 3));
+				for (int axis = 0; axis < 3; axis++)
+				{
+					object.position[axis] = std::min(m_extent, std::max(-m_extent, clusters[cluster + axis] + scatter(random)));
+				}
+				break;
+			}
+			default:
+				for (int axis = 0; axis < 3; axis++)
+				{
+					object.position[axis] = (unit(random) * 2.0f - 1.0f) * m_extent;
+				}
+				break;
+			}
+
+			if (i - numOccluders < numAnimated)
+			{
+				object.spin = (unit(random) * 2.0f - 1.0f) * MAX_SPIN;
+				m_animated.push_back(i);
+			}
+		}
+
+		place(i, 0.0f);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Moves the animated objects to t_time; static ones are left untouched
+/// </summary>
+void StressScene::animate(float t_time)
+{
+	for (uint32_t index : m_animated)
+	{
+		place(index, t_time);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Model matrix translate * rotateY * scale of one object, and the bounds of
+/// the unit cube under it
+/// </summary>
+void StressScene::place(size_t t_index, float t_time)
+{
+	const StressObject& object = m_objects[t_index];
+	const float angle = object.phase + object.spin * t_time;
+	const float c = cosf(angle);
+	const float s = sinf(angle);
+	float* m = m_drawData[t_index].model;
+
+	m[0] = c * object.scale[0];  m[1] = 0.0f;              m[2] = -s * object.scale[0]; m[3] = 0.0f;
+	m[4] = 0.0f;                 m[5] = object.scale[1];   m[6] = 0.0f;                 m[7] = 0.0f;
+	m[8] = s * object.scale[2];  m[9] = 0.0f;              m[10] = c * object.scale[2]; m[11] = 0.0f;
+	m[12] = object.position[0];  m[13] = object.position[1]; m[14] = object.position[2]; m[15] = 1.0f;
+
+	const float half[3] = {
+		0.5f * (fabsf(c) * object.scale[0] + fabsf(s) * object.scale[2]),
+		0.5f * object.scale[1],
+		0.5f * (fabsf(s) * object.scale[0] + fabsf(c) * object.scale[2])
+	};
+
+	BoundingBox& bounds = m_bounds[t_index];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		bounds.min[axis] = object.position[axis] - half[axis];
+		bounds.max[axis] = object.position[axis] + half[axis];
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Prints one row per object count, sorted by count, and marks the knees
+/// </summary>
+void StressScene::report(const std::vector<StressResult>& t_results, std::ostream& t_out)
+{
+	const std::ios::fmtflags flags = t_out.flags();
+	const std::streamsize precision = t_out.precision();
+
+	t_out << std::left << std::setw(10) << "objects" << std::right
+		<< std::setw(10) << "drawn" << std::setw(10) << "culled" << std::setw(8) << "calls"
+		<< std::setw(12) << "frame ms" << std::setw(10) << "cpu ms" << std::setw(10) << "fps"
+		<< std::setw(12) << "us/object" << std::setw(12) << "Mtri/s" << std::endl;
+
+	double best = 0.0;
+	unsigned firstKnee = 0;
+
+	for (const StressResult& result : t_results)
+	{
+		const double perObject = result.objects > 0 ? 1000.0 * result.frameMs / result.objects : 0.0;
+		const bool knee = best > 0.0 && perObject > best * (1.0 + KNEE_GROWTH);
+		if (perObject > 0.0 && (best == 0.0 || perObject < best)) best = perObject;
+		if (knee && firstKnee == 0) firstKnee = result.objects;
+
+		t_out << std::left << std::setw(10) << result.objects << std::right << std::fixed
+			<< std::setprecision(0) << std::setw(10) << result.drawn << std::setw(10) << result.culled << std::setw(8) << result.drawCalls
+			<< std::setprecision(3) << std::setw(12) << result.frameMs << std::setw(10) << result.cpuMs
+			<< std::setprecision(1) << std::setw(10) << (result.frameMs > 0.0 ? 1000.0 / result.frameMs : 0.0)
+			<< std::setprecision(3) << std::setw(12) << perObject
+			<< std::setprecision(2) << std::setw(12) << (result.frameMs > 0.0 ? result.triangles / result.frameMs / 1000.0 : 0.0)
+			<< (knee ? "  <- knee" : "") << std::endl;
+	}
+
+	if (firstKnee > 0)
+	{
+		t_out << "Cost per object first rose more than " << static_cast<int>(KNEE_GROWTH * 100.0) << "% above its best at "
+			<< firstKnee << " objects" << std::endl;
+	}
+	else
+	{
+		t_out << "No knee: cost per object never rose more than " << static_cast<int>(KNEE_GROWTH * 100.0) << "% above its best" << std::endl;
+	}
+
+	t_out.flags(flags);
+	t_out.precision(precision);
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Writes the sweep as CSV with a header row, for plotting throughput against N
+/// </summary>
+/// <returns>true if the file was written</returns>
+bool StressScene::saveCsv(const std::string& t_fileSrc, const std::vector<StressResult>& t_results)
+{
+	std::ofstream file(t_fileSrc);
+	if (!file)
+	{
+		DEBUG_MSG("ERROR: Cannot write stress results: " + t_fileSrc);
+		return false;
+	}
+
+	file << "objects,drawn,culled,draw_calls,triangles,frame_ms,cpu_ms,fps,objects_per_second,triangles_per_second\n";
+	for (const StressResult& result : t_results)
+	{
+		const double perSecond = result.frameMs > 0.0 ? 1000.0 / result.frameMs : 0.0;
+		file << result.objects << ',' << result.drawn << ',' << result.culled << ',' << result.drawCalls << ','
+			<< result.triangles << ',' << result.frameMs << ',' << result.cpuMs << ',' << perSecond << ','
+			<< result.objects * perSecond << ',' << result.triangles * perSecond << '\n';
+	}
+
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,105 @@
+#ifndef STRESS_SCENE_H
+#define STRESS_SCENE_H
+
+#include <Mesh.h>
+#include <RenderQueue.h>
+#include <OcclusionCuller.h>
+#include <AssetLoader.h>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum StressDistribution
+{
+	GRID_DISTRIBUTION, // evenly spaced lattice
+	RANDOM_DISTRIBUTION, // uniform in a cube
+	CLUSTERED_DISTRIBUTION // tight groups scattered through the cube
+};
+
+/// <summary>
+/// Knobs of a generated scene; the object count is swept separately
+/// </summary>
+struct StressParams
+{
+	unsigned complexity = 1; // each cube triangle split into complexity^2, 1 is the cube as is
+	StressDistribution distribution = RANDOM_DISTRIBUTION;
+	float animatedFraction = 0.25f; // objects whose transform changes every frame
+	float occluderFraction = 0.01f; // objects stretched into walls in front of the rest
+	bool occlusionCulling = true; // test the rest against the occluders' depth pyramid
+	float spacing = 2.0f; // average distance between object centres
+	uint32_t seed = 1;
+};
+
+/// <summary>
+/// Placement of one object. Static objects keep their initial rotation.
+/// </summary>
+struct StressObject
+{
+	float position[3];
+	float scale[3];
+	float phase; // rotation about y at time 0, radians
+	float spin; // radians per second, 0 if static
+	bool occluder;
+};
+
+/// <summary>
+/// Averages over the measured frames of one object count
+/// </summary>
+struct StressResult
+{
+	unsigned objects = 0;
+	double drawn = 0.0;
+	double culled = 0.0;
+	double drawCalls = 0.0;
+	double triangles = 0.0; // drawn per frame
+	double frameMs = 0.0; // median, CPU submission through glFinish
+	double cpuMs = 0.0; // median, culling and submission only
+};
+
+/// <summary>
+/// Generates scenes of many copies of one mesh for scaling studies.
+///
+/// buildMesh() turns the cube's Vertex array and triangles[] index pattern
+/// into a mesh of any complexity by splitting every triangle into smaller
+/// ones with the same winding, interpolating position and colour.
+/// generate() places the objects; animate() recomputes the model matrix and
+/// bounds of only the animated ones, so the animated fraction scales the
+/// per-frame CPU work the way moving objects do in a real scene.
+///
+/// report() prints the sweep and marks scaling knees: counts where the cost
+/// per object climbs more than KNEE_GROWTH above the cheapest seen so far,
+/// meaning frame time has started to grow faster than the object count.
+/// </summary>
+class StressScene
+{
+public:
+	static const double KNEE_GROWTH; // 0.25 = 25% above the best cost per object
+
+	static bool parseDistribution(const std::string& t_name, StressDistribution& t_distribution);
+	static void buildMesh(const Vertex* t_corners, const GLubyte* t_triangles, int t_numTriangles, unsigned t_complexity, MeshData& t_mesh);
+
+	void generate(const StressParams& t_params, unsigned t_objects);
+	void animate(float t_time);
+
+	size_t size() const { return m_objects.size(); }
+	const StressObject& getObject(size_t t_index) const { return m_objects[t_index]; }
+	const DrawData& getDrawData(size_t t_index) const { return m_drawData[t_index]; }
+	const BoundingBox& getBounds(size_t t_index) const { return m_bounds[t_index]; }
+	float getExtent() const { return m_extent; } // half size of the cube the objects fill
+
+	static void report(const std::vector<StressResult>& t_results, std::ostream& t_out);
+	static bool saveCsv(const std::string& t_fileSrc, const std::vector<StressResult>& t_results);
+
+private:
+	void place(size_t t_index, float t_time);
+
+	std::vector<StressObject> m_objects;
+	std::vector<DrawData> m_drawData;
+	std::vector<BoundingBox> m_bounds;
+	std::vector<uint32_t> m_animated; // indices of objects with a non-zero spin
+	float m_extent = 0.0f;
+};
+
+#endif
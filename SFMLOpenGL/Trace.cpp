@@ -0,0 +1,315 @@
+#include <Trace.h>
+#include <Debug.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace
+{
+	struct Event
+	{
+		const char* name;
+		const char* category;
+		int64_t start;
+		int64_t duration;
+	};
+
+	// Rows of exited threads kept for save() once their buffer is reused
+	const size_t MAX_RETIRED_ROWS = 16;
+
+	/// <summary>
+	/// Ring of one thread's events. Only the owning thread writes; save()
+	/// takes the lock briefly to copy it, so the lock is almost never contended.
+	/// Buffers outlive their threads and are handed to the next new thread,
+	/// so short-lived threads reuse memory instead of piling up.
+	/// </summary>
+	struct ThreadBuffer
+	{
+		std::mutex mutex;
+		std::vector<Event> events;
+		uint64_t written = 0; // total ever, the ring holds the last EVENTS_PER_THREAD
+		uint32_t id = 0;
+		std::string name;
+		bool inUse = true;
+	};
+
+	/// <summary>
+	/// One thread's row in the saved trace, oldest event first
+	/// </summary>
+	struct Row
+	{
+		uint32_t id;
+		std::string name;
+		std::vector<Event> events;
+	};
+
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		std::deque<Row> retired; // newest last, at most MAX_RETIRED_ROWS
+		std::set<std::string> names; // interned, nodes never move
+		uint32_t nextId = 1;
+	};
+
+	Registry& registry()
+	{
+		static Registry instance;
+		return instance;
+	}
+
+	const std::chrono::steady_clock::time_point EPOCH = std::chrono::steady_clock::now();
+
+	volatile std::sig_atomic_t requested = 0;
+
+	void onSignal(int t_signal)
+	{
+		requested = 1;
+		std::signal(t_signal, onSignal); // some platforms reset the handler once it has run
+	}
+
+	/// <summary>
+	/// Returns the buffer to the registry when its thread exits
+	/// </summary>
+	struct BufferHolder
+	{
+		ThreadBuffer* buffer = nullptr;
+
+		~BufferHolder()
+		{
+			if (buffer)
+			{
+				std::lock_guard<std::mutex> lock(registry().mutex);
+				buffer->inUse = false;
+			}
+		}
+	};
+
+	thread_local BufferHolder holder;
+
+	/// <summary>
+	/// Copies a buffer's ring; the caller holds its lock
+	/// </summary>
+	Row copyRow(const ThreadBuffer& t_buffer)
+	{
+		Row row;
+		row.id = t_buffer.id;
+		row.name = t_buffer.name.empty() ? "thread " + std::to_string(t_buffer.id) : t_buffer.name;
+
+		const uint64_t count = std::min<uint64_t>(t_buffer.written, Trace::EVENTS_PER_THREAD);
+		row.events.reserve(static_cast<size_t>(count));
+		for (uint64_t i = t_buffer.written - count; i < t_buffer.written; i++)
+		{
+			row.events.push_back(t_buffer.events[i % Trace::EVENTS_PER_THREAD]);
+		}
+
+		return row;
+	}
+
+	/// <summary>
+	/// This thread's buffer, taken from an exited thread or created on first use.
+	/// A taken buffer gets a new row; the old thread's events move to the retired rows.
+	/// </summary>
+	ThreadBuffer& threadBuffer()
+	{
+		if (holder.buffer)
+		{
+			return *holder.buffer;
+		}
+
+		Registry& shared = registry();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+
+		for (std::unique_ptr<ThreadBuffer>& buffer : shared.buffers)
+		{
+			if (!buffer->inUse)
+			{
+				std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+				if (buffer->written > 0)
+				{
+					shared.retired.push_back(copyRow(*buffer));
+					if (shared.retired.size() > MAX_RETIRED_ROWS) shared.retired.pop_front();
+				}
+
+				buffer->written = 0;
+				buffer->id = shared.nextId++;
+				buffer->name.clear();
+				buffer->inUse = true;
+				holder.buffer = buffer.get();
+				return *holder.buffer;
+			}
+		}
+
+		shared.buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+		ThreadBuffer& buffer = *shared.buffers.back();
+		buffer.events.resize(Trace::EVENTS_PER_THREAD);
+		buffer.id = shared.nextId++;
+		holder.buffer = &buffer;
+		return buffer;
+	}
+
+	/// <summary>
+	/// Writes t_text as a JSON string, escaping what needs it
+	/// </summary>
+	void writeString(FILE* t_file, const char* t_text)
+	{
+		std::fputc('"', t_file);
+		for (const char* at = t_text; *at != '\0'; at++)
+		{
+			if (*at == '"' || *at == '\\') std::fputc('\\', t_file);
+			if (static_cast<unsigned char>(*at) >= 0x20) std::fputc(*at, t_file);
+		}
+		std::fputc('"', t_file);
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+int64_t Trace::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - EPOCH).count();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Appends one complete event to this thread's ring, overwriting the oldest
+/// </summary>
+/// <param name="t_start">from now()</param>
+/// <param name="t_end">from now()</param>
+void Trace::record(const char* t_name, const char* t_category, int64_t t_start, int64_t t_end)
+{
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+
+	Event& event = buffer.events[buffer.written % EVENTS_PER_THREAD];
+	event.name = t_name;
+	event.category = t_category;
+	event.start = t_start;
+	event.duration = t_end - t_start;
+	buffer.written++;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Labels this thread's row in the viewer
+/// </summary>
+void Trace::setThreadName(const std::string& t_name)
+{
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.name = t_name;
+}
+
+/////////////////////////////////////////////////////////
+
+const char* Trace::intern(const std::string& t_name)
+{
+	Registry& shared = registry();
+	std::lock_guard<std::mutex> lock(shared.mutex);
+	return shared.names.insert(t_name).first->c_str();
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Makes SIGUSR1, or SIGBREAK where there is no SIGUSR1, request a trace
+/// </summary>
+void Trace::installSignalHandler()
+{
+#if defined(SIGUSR1)
+	std::signal(SIGUSR1, onSignal);
+#elif defined(SIGBREAK)
+	std::signal(SIGBREAK, onSignal);
+#endif
+}
+
+/////////////////////////////////////////////////////////
+
+void Trace::request()
+{
+	requested = 1;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Clears a pending request from request() or the signal handler
+/// </summary>
+/// <returns>true if one was pending</returns>
+bool Trace::takeRequest()
+{
+	if (requested == 0) return false;
+
+	requested = 0;
+	return true;
+}
+
+/////////////////////////////////////////////////////////
+
+/// <summary>
+/// Writes every thread's ring, and the rows kept from exited threads, oldest event first, as a Chrome trace.
+/// Threads keep recording while their ring is copied.
+/// </summary>
+/// <returns>true if the file was written</returns>
+bool Trace::save(const std::string& t_fileSrc)
+{
+	std::vector<Row> threads;
+	{
+		Registry& shared = registry();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+
+		threads.assign(shared.retired.begin(), shared.retired.end());
+
+		for (std::unique_ptr<ThreadBuffer>& buffer : shared.buffers)
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+			threads.push_back(copyRow(*buffer));
+		}
+	}
+
+	FILE* file = std::fopen(t_fileSrc.c_str(), "wb");
+	if (!file)
+	{
+		DEBUG_MSG("ERROR: Cannot write trace: " + t_fileSrc);
+		return false;
+	}
+
+	size_t numEvents = 0;
+	std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+	std::fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"SFMLOpenGL\"}}", file);
+
+	for (const Row& thread : threads)
+	{
+		std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", thread.id);
+		writeString(file, thread.name.c_str());
+		std::fputs("}}", file);
+
+		for (const Event& event : thread.events)
+		{
+			std::fputs(",\n{\"name\":", file);
+			writeString(file, event.name);
+			std::fputs(",\"cat\":", file);
+			writeString(file, event.category);
+			std::fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				thread.id, event.start / 1000.0, event.duration / 1000.0);
+			numEvents++;
+		}
+	}
+
+	std::fputs("\n]}\n", file);
+	const bool written = std::ferror(file) == 0;
+	std::fclose(file);
+
+	DEBUG_MSG("Wrote " + std::to_string(numEvents) + " trace events from " + std::to_string(threads.size()) + " threads to " + t_fileSrc);
+	return written;
+}
@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+//Define TRACE_ENABLED 0 to compile every marker out; nothing is recorded and no buffers are made
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Timeline of scoped markers from every thread, written on request as
+/// Chrome Trace Event JSON for chrome://tracing or ui.perfetto.dev.
+///
+/// Each thread records into its own ring of EVENTS_PER_THREAD complete
+/// events, so a marker costs two clock reads and an uncontended lock, and
+/// the rings always hold the last few seconds: press the trace key after a
+/// janky frame and it is in the file. Names and categories are not copied,
+/// so they must be string literals or come from intern().
+///
+/// A trace is requested with request(), or by SIGUSR1 (Ctrl+Break on
+/// Windows) once installSignalHandler() has run; the render loop picks the
+/// request up with takeRequest() and calls save().
+/// </summary>
+class Trace
+{
+public:
+	static const size_t EVENTS_PER_THREAD = 16384;
+
+	static int64_t now(); // nanoseconds on the trace clock
+
+	static void record(const char* t_name, const char* t_category, int64_t t_start, int64_t t_end);
+	static void setThreadName(const std::string& t_name);
+	static const char* intern(const std::string& t_name); // stable copy for names built at runtime
+
+	static void installSignalHandler();
+	static void request();
+	static bool takeRequest();
+
+	static bool save(const std::string& t_fileSrc);
+};
+
+/// <summary>
+/// Records its own lifetime as one trace event
+/// </summary>
+class TraceScope
+{
+public:
+	TraceScope(const char* t_name, const char* t_category) : m_name{ t_name }, m_category{ t_category }, m_start{ Trace::now() } {}
+	~TraceScope() { Trace::record(m_name, m_category, m_start, Trace::now()); }
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* m_name;
+	const char* m_category;
+	int64_t m_start;
+};
+
+//MACROS for a marker covering the rest of the enclosing block, and for labelling this thread's row
+#if (TRACE_ENABLED >= 1)
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name, category) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, category)
+#define TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+#else
+#define TRACE_SCOPE(name, category)
+#define TRACE_THREAD_NAME(name)
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+#include "Trig.h"
+#include <math.h>
+
+using namespace gpp;
+
+namespace
+{
+	const float TWO_OVER_PI = 0.636619772367581343f;
+	const float HALF_PI = 1.57079632679489662f;
+	const float PI_F = 3.14159265358979324f;
+
+	// pi/2 split into three parts for Cody-Waite range reduction. The first two
+	// have 8 and 11 significant bits, so j * part fits in a float's 24 exactly
+	// for |j| < 2^13; |angle| <= 8192 needs |j| <= 5216
+	const float PIO2_1 = 1.5703125f;
+	const float PIO2_2 = 4.837512969970703125e-4f;
+	const float PIO2_3 = 7.54978995489188216e-8f;
+
+	// Minimax coefficients on [-pi/4, pi/4] (Cephes sinf / cosf)
+	const float S1 = -1.6666654611e-1f, S2 = 8.3321608736e-3f, S3 = -1.9515295891e-4f;
+	const float C1 = 4.166664568298827e-2f, C2 = -1.388731625493765e-3f, C3 = 2.443315711809948e-5f;
+
+	// Minimax coefficients for asin on [0, 0.5] (Cephes asinf)
+	const float A1 = 1.6666752422e-1f, A2 = 7.4953002686e-2f, A3 = 4.5470025998e-2f,
+		A4 = 2.4181311049e-2f, A5 = 4.2163199048e-2f;
+
+	/// <summary>
+	/// Polynomial sincos, written without branches so it vectorises in loops
+	/// </summary>
+	inline void fastSinCos(const float t_x, float& t_sin, float& t_cos)
+	{
+		// nearest quadrant, rounding half away from zero
+		int quadrant = static_cast<int>(t_x * TWO_OVER_PI + (t_x >= 0.0f ? 0.5f : -0.5f));
+		float j = static_cast<float>(quadrant);
+
+		float r = ((t_x - j * PIO2_1) - j * PIO2_2) - j * PIO2_3; // r in [-pi/4, pi/4]
+		float r2 = r * r;
+
+		float s = r + r * r2 * (S1 + r2 * (S2 + r2 * S3));
+		float c = 1.0f - 0.5f * r2 + r2 * r2 * (C1 + r2 * (C2 + r2 * C3));
+
+		// rotate (s, c) by the quadrant: odd quadrants swap, quadrants 2 and 3 negate
+		bool swap = (quadrant & 1) != 0;
+		float sinValue = swap ? c : s;
+		float cosValue = swap ? s : c;
+		t_sin = ((quadrant & 2) != 0) ? -sinValue : sinValue;
+		t_cos = (((quadrant + 1) & 2) != 0) ? -cosValue : cosValue;
+	}
+}
+
+/// <summary>
+/// Computes sine and cosine of an angle together
+/// </summary>
+/// <param name="t_angleRadians">angle in radians</param>
+/// <param name="t_sin">receives the sine</param>
+/// <param name="t_cos">receives the cosine</param>
+/// <param name="t_accuracy">EXACT or FAST</param>
+void Trig::sincos(const float t_angleRadians, float& t_sin, float& t_cos, const TrigAccuracy t_accuracy)
+{
+	if (t_accuracy == FAST)
+	{
+		fastSinCos(t_angleRadians, t_sin, t_cos);
+	}
+	else
+	{
+		t_sin = sinf(t_angleRadians);
+		t_cos = cosf(t_angleRadians);
+	}
+}
+
+/// <summary>
+/// Computes the arc cosine of a value
+/// </summary>
+/// <param name="t_x">cosine of the angle</param>
+/// <param name="t_accuracy">EXACT or FAST</param>
+/// <returns>angle in radians, 0 to pi</returns>
+float Trig::acos(const float t_x, const TrigAccuracy t_accuracy)
+{
+	float x = (t_x > 1.0f) ? 1.0f : (t_x < -1.0f) ? -1.0f : t_x;
+
+	if (t_accuracy == EXACT)
+	{
+		return acosf(x);
+	}
+
+	float a = fabsf(x);
+
+	if (a > 0.5f)
+	{
+		// acos(a) = 2 asin(sqrt((1 - a) / 2))
+		float z = 0.5f * (1.0f - a);
+		float s = sqrtf(z);
+		float asinS = s + s * z * (A1 + z * (A2 + z * (A3 + z * (A4 + z * A5))));
+		return (x > 0.0f) ? 2.0f * asinS : PI_F - 2.0f * asinS;
+	}
+
+	float z = x * x;
+	float asinX = x + x * z * (A1 + z * (A2 + z * (A3 + z * (A4 + z * A5))));
+	return HALF_PI - asinX;
+}
+
+/// <summary>
+/// Computes sine and cosine for an array of angles
+/// </summary>
+/// <param name="t_anglesRadians">t_count angles in radians</param>
+/// <param name="t_sin">receives t_count sines</param>
+/// <param name="t_cos">receives t_count cosines</param>
+/// <param name="t_count">number of angles</param>
+/// <param name="t_accuracy">EXACT or FAST</param>
+void Trig::sincos(const float* t_anglesRadians, float* t_sin, float* t_cos, const size_t t_count,
+	const TrigAccuracy t_accuracy)
+{
+	if (t_accuracy == FAST)
+	{
+		for (size_t i = 0; i < t_count; i++)
+		{
+			fastSinCos(t_anglesRadians[i], t_sin[i], t_cos[i]);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < t_count; i++)
+		{
+			t_sin[i] = sinf(t_anglesRadians[i]);
+			t_cos[i] = cosf(t_anglesRadians[i]);
+		}
+	}
+}
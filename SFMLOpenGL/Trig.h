@@ -0,0 +1,41 @@
+#ifndef MY_TRIG
+#define MY_TRIG
+#include <cstddef>
+
+namespace gpp
+{
+	/// <summary>
+	/// Accuracy of a trig call. EXACT uses the C runtime in float precision.
+	/// FAST uses the minimax polynomials below; error bounds were measured
+	/// against double precision over the stated input range by --selftest.
+	/// </summary>
+	enum TrigAccuracy
+	{
+		EXACT,
+		FAST
+	};
+
+	namespace Trig
+	{
+		/// <summary>
+		/// Fused sine and cosine sharing one range reduction.
+		/// FAST: for |angle| <= 8192, max error 2 ulp where |result| > 1e-3
+		/// and absolute error below 1e-7 everywhere.
+		/// </summary>
+		void sincos(const float t_angleRadians, float& t_sin, float& t_cos, const TrigAccuracy t_accuracy = EXACT);
+
+		/// <summary>
+		/// Arc cosine in radians, argument clamped to [-1, 1].
+		/// FAST: max error 2 ulp over [-1, 1].
+		/// </summary>
+		float acos(const float t_x, const TrigAccuracy t_accuracy = EXACT);
+
+		/// <summary>
+		/// sincos over arrays. The FAST path is branch-free so the compiler
+		/// can vectorise it; same error bounds as the scalar version.
+		/// </summary>
+		void sincos(const float* t_anglesRadians, float* t_sin, float* t_cos, const size_t t_count,
+			const TrigAccuracy t_accuracy = EXACT);
+	}
+}
+#endif // !MY_TRIG
@@ -1,4 +1,5 @@
 #include "Vector3.h"
+#include "Serialization.h"
 
 #define PI 3.14159265358979323846
 
@@ -26,6 +27,75 @@ std::string Vector3::toString()
 
 ///////////////////////////////////////////////////////////////////////
 
+/// <summary>
+/// Formats as "[x,y,z]" into a caller-supplied buffer, without allocating.
+/// Components use the shortest form that reads back to the same float, so
+/// the digits differ from toString(), which always prints six decimals.
+/// </summary>
+/// <param name="t_buffer">destination, MAX_FORMAT_LENGTH always suffices</param>
+/// <param name="t_size">size of t_buffer in chars</param>
+/// <returns>characters written excluding the null, or 0 if t_buffer is too small</returns>
+size_t Vector3::format(char* t_buffer, const size_t t_size) const
+{
+	if (t_size == 0) return 0;
+
+	char* cursor = t_buffer;
+	char* end = t_buffer + t_size - 1; // leave room for the null
+
+	bool fits = Text::append(cursor, end, '[')
+		&& Text::append(cursor, end, x) && Text::append(cursor, end, ',')
+		&& Text::append(cursor, end, y) && Text::append(cursor, end, ',')
+		&& Text::append(cursor, end, z) && Text::append(cursor, end, ']');
+
+	*cursor = '\0';
+
+	return fits ? static_cast<size_t>(cursor - t_buffer) : 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3::serialize(unsigned char* t_dst) const
+{
+	t_dst = Binary::writeFloat(t_dst, x);
+	t_dst = Binary::writeFloat(t_dst, y);
+	Binary::writeFloat(t_dst, z);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3 Vector3::deserialize(const unsigned char* t_src)
+{
+	Vector3 result;
+
+	t_src = Binary::readFloat(t_src, result.x);
+	t_src = Binary::readFloat(t_src, result.y);
+	Binary::readFloat(t_src, result.z);
+
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3::serializeArray(const Vector3* t_vectors, const size_t t_count, unsigned char* t_dst)
+{
+	for (size_t i = 0; i < t_count; i++)
+	{
+		t_vectors[i].serialize(t_dst + i * SERIALIZED_SIZE);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3::deserializeArray(const unsigned char* t_src, const size_t t_count, Vector3* t_vectors)
+{
+	for (size_t i = 0; i < t_count; i++)
+	{
+		t_vectors[i] = deserialize(t_src + i * SERIALIZED_SIZE);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+
 Vector3::Vector3(sf::Vector3f t_sfVector) :
 	x{ t_sfVector.x },
 	y{ t_sfVector.y },
@@ -196,7 +266,7 @@ Vector3 Vector3::crossProduct(const Vector3 t_other) const
 
 ///////////////////////////////////////////////////////////////////////
 
-float Vector3::angleBetween(const Vector3 t_other) const
+float Vector3::angleBetween(const Vector3 t_other, const TrigAccuracy t_accuracy) const
 {
 	Vector3 newVector{ x,y,z }; // assigned values of left operand via 'this' pointer
 
@@ -208,8 +278,9 @@ float Vector3::angleBetween(const Vector3 t_other) const
 
 	if (lengthProduct != 0) // avoid division by zero
 	{
-		angleBetween = acos(dotProduct / lengthProduct); // angle = cos ((u.v) / ||u|| * ||v||), .'. acos = answer.
-		angleBetweenDegrees = angleBetween * (180 / PI); // convert result to degrees
+		// angle = cos ((u.v) / ||u|| * ||v||), .'. acos = answer.
+		angleBetween = (t_accuracy == FAST) ? Trig::acos(dotProduct / lengthProduct, FAST) : acos(dotProduct / lengthProduct);
+		angleBetweenDegrees = angleBetween * static_cast<float>(180 / PI); // convert result to degrees
 	}
 	else
 	{
@@ -1,6 +1,7 @@
 #pragma once
 #include <iostream>
 #include <SFML/Graphics.hpp>
+#include "Trig.h"
 
 namespace gpp
 {
@@ -26,6 +27,34 @@ namespace gpp
 		/// </summary>
 		std::string toString();
 
+		static const size_t MAX_FORMAT_LENGTH = 64; // buffer size that fits any vector, including the null
+		static const size_t SERIALIZED_SIZE = 12; // bytes per vector
+
+		/// <summary>
+		/// @brief Formats as "[x,y,z]" into a caller-supplied buffer without allocating
+		/// </summary>
+		size_t format(char* t_buffer, const size_t t_size) const;
+
+		/// <summary>
+		/// @brief Writes SERIALIZED_SIZE little-endian bytes
+		/// </summary>
+		void serialize(unsigned char* t_dst) const;
+
+		/// <summary>
+		/// @brief Reads a vector written by serialize()
+		/// </summary>
+		static Vector3 deserialize(const unsigned char* t_src);
+
+		/// <summary>
+		/// @brief Serializes t_count vectors back to back
+		/// </summary>
+		static void serializeArray(const Vector3* t_vectors, const size_t t_count, unsigned char* t_dst);
+
+		/// <summary>
+		/// @brief Reads t_count vectors written by serializeArray()
+		/// </summary>
+		static void deserializeArray(const unsigned char* t_src, const size_t t_count, Vector3* t_vectors);
+
 
 		// Casting an SFML vector to Vector3 vector
 		Vector3(float t_x, float t_y, float t_z) : x{ t_x }, y{ t_y }, z{ t_z } {}
@@ -140,9 +169,9 @@ namespace gpp
 		Vector3 crossProduct(const Vector3 t_other)const;
 
 		/// <summary>
-		/// @brief Get the angle between two vectors
+		/// @brief Get the angle between two vectors, in degrees
 		/// </summary>
-		float angleBetween(const Vector3 t_other)const;
+		float angleBetween(const Vector3 t_other, const TrigAccuracy t_accuracy = EXACT)const;
 
 		/// <summary>
 		/// @brief Return the unit vector of a given vector
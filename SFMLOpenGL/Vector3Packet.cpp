@@ -0,0 +1,393 @@
+#include "Vector3Packet.h"
+#include "Vector3PacketImpl.h"
+#include <math.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#endif
+
+using namespace gpp;
+
+static_assert(sizeof(Vector3x4) == 3 * Vector3x4::WIDTH * sizeof(float), "Vector3x4 packets must be tightly packed");
+static_assert(sizeof(Vector3x8) == 3 * Vector3x8::WIDTH * sizeof(float), "Vector3x8 packets must be tightly packed");
+
+namespace
+{
+	/// <summary>
+	/// One-lane fallback register, for CPUs without SSE4.1
+	/// </summary>
+	struct ScalarV
+	{
+		static const int WIDTH = 1;
+		typedef bool Mask;
+
+		float r;
+
+		static ScalarV make(float t_r) { ScalarV v; v.r = t_r; return v; }
+		static ScalarV load(const float* t_p) { return make(*t_p); }
+		static void store(float* t_p, ScalarV t_v) { *t_p = t_v.r; }
+		static ScalarV loadSplit(const float* t_low, const float*) { return load(t_low); }
+		static void storeSplit(float* t_low, float*, ScalarV t_v) { store(t_low, t_v); }
+		static ScalarV add(ScalarV t_a, ScalarV t_b) { return make(t_a.r + t_b.r); }
+		static ScalarV sub(ScalarV t_a, ScalarV t_b) { return make(t_a.r - t_b.r); }
+		static ScalarV mul(ScalarV t_a, ScalarV t_b) { return make(t_a.r * t_b.r); }
+		static ScalarV div(ScalarV t_a, ScalarV t_b) { return make(t_a.r / t_b.r); }
+		static ScalarV sqrt(ScalarV t_a) { return make(sqrtf(t_a.r)); }
+		static ScalarV zero() { return make(0.0f); }
+		static Mask greaterThanZero(ScalarV t_a) { return t_a.r > 0.0f; }
+		static Mask notZero(ScalarV t_a) { return t_a.r != 0.0f; }
+		static ScalarV select(Mask t_mask, ScalarV t_a, ScalarV t_b) { return t_mask ? t_a : t_b; }
+	};
+
+	/// <summary>
+	/// Runs CPUID for a leaf / subleaf, all zero if unavailable
+	/// </summary>
+	void cpuid(int t_registers[4], int t_leaf, int t_subleaf)
+	{
+		t_registers[0] = t_registers[1] = t_registers[2] = t_registers[3] = 0;
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+		__cpuidex(t_registers, t_leaf, t_subleaf);
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+		unsigned int a, b, c, d;
+		if (__get_cpuid_count(t_leaf, t_subleaf, &a, &b, &c, &d))
+		{
+			t_registers[0] = a, t_registers[1] = b, t_registers[2] = c, t_registers[3] = d;
+		}
+#endif
+	}
+
+	/// <summary>
+	/// Reads XCR0, the register state the OS saves on context switches
+	/// </summary>
+	unsigned long long xcr0()
+	{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+		return _xgetbv(0);
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+		unsigned int low, high;
+		__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return (static_cast<unsigned long long>(high) << 32) | low;
+#else
+		return 0;
+#endif
+	}
+
+	const PacketKernels::Table& tableFor(const SimdLevel t_level)
+	{
+		switch (t_level)
+		{
+		case SIMD_AVX512: return PacketKernels::avx512Table();
+		case SIMD_AVX2: return PacketKernels::avx2Table();
+		case SIMD_SSE41: return PacketKernels::sse41Table();
+		default: return PacketKernels::scalarTable();
+		}
+	}
+
+	SimdLevel& level()
+	{
+		static SimdLevel level = Simd::detect();
+		return level;
+	}
+
+	const PacketKernels::Table*& table()
+	{
+		static const PacketKernels::Table* table = &tableFor(level());
+		return table;
+	}
+
+	const float* lanes(const void* t_packets) { return static_cast<const float*>(t_packets); }
+	float* lanes(void* t_packets) { return static_cast<float*>(t_packets); }
+}
+
+///////////////////////////////////////////////////////////////////////
+
+const PacketKernels::Table& PacketKernels::scalarTable()
+{
+	static const Table table = {
+		&Entry<ScalarV, 4, scalarTable>::dot, &Entry<ScalarV, 4, scalarTable>::cross,
+		&Entry<ScalarV, 4, scalarTable>::unit, &Entry<ScalarV, 4, scalarTable>::project,
+		&Entry<ScalarV, 8, scalarTable>::dot, &Entry<ScalarV, 8, scalarTable>::cross,
+		&Entry<ScalarV, 8, scalarTable>::unit, &Entry<ScalarV, 8, scalarTable>::project
+	};
+
+	return table;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+SimdLevel Simd::detect()
+{
+	int leaf1[4], leaf7[4];
+	cpuid(leaf1, 1, 0);
+	cpuid(leaf7, 7, 0);
+
+	const bool sse41 = (leaf1[2] & (1 << 19)) != 0;
+	const bool osxsave = (leaf1[2] & (1 << 27)) != 0;
+	const bool avx = (leaf1[2] & (1 << 28)) != 0;
+	const bool avx2 = (leaf7[1] & (1 << 5)) != 0;
+	const bool avx512f = (leaf7[1] & (1 << 16)) != 0;
+
+	const unsigned long long state = osxsave ? xcr0() : 0;
+	const bool ymmSaved = (state & 0x6) == 0x6; // SSE and AVX state
+	const bool zmmSaved = (state & 0xE6) == 0xE6; // plus opmask and upper ZMM state
+
+	if (avx512f && avx2 && avx && zmmSaved) return SIMD_AVX512;
+	if (avx2 && avx && ymmSaved) return SIMD_AVX2;
+	if (sse41) return SIMD_SSE41;
+	return SIMD_SCALAR;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+SimdLevel Simd::active()
+{
+	return level();
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Simd::setLevel(const SimdLevel t_level)
+{
+	SimdLevel supported = detect();
+	level() = (t_level < supported) ? t_level : supported;
+	table() = &tableFor(level());
+}
+
+///////////////////////////////////////////////////////////////////////
+
+const char* Simd::name(const SimdLevel t_level)
+{
+	switch (t_level)
+	{
+	case SIMD_AVX512: return "AVX-512";
+	case SIMD_AVX2: return "AVX2";
+	case SIMD_SSE41: return "SSE4.1";
+	default: return "scalar";
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x4 Vector3x4::load(const Vector3* t_vectors, const size_t t_count)
+{
+	Vector3x4 packet;
+
+	for (size_t i = 0; i < WIDTH; i++)
+	{
+		bool used = i < t_count;
+		packet.x[i] = used ? t_vectors[i].x : 0.0f;
+		packet.y[i] = used ? t_vectors[i].y : 0.0f;
+		packet.z[i] = used ? t_vectors[i].z : 0.0f;
+	}
+
+	return packet;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x4::store(Vector3* t_vectors, const size_t t_count) const
+{
+	for (size_t i = 0; i < t_count && i < WIDTH; i++)
+	{
+		t_vectors[i] = Vector3(x[i], y[i], z[i]);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x4::dot(const Vector3x4& t_other, float t_result[WIDTH]) const
+{
+	table()->dot4(lanes(this), lanes(&t_other), t_result, 1);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x4 Vector3x4::crossProduct(const Vector3x4& t_other) const
+{
+	Vector3x4 result;
+	table()->cross4(lanes(this), lanes(&t_other), lanes(&result), 1);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x4 Vector3x4::unit() const
+{
+	Vector3x4 result;
+	table()->unit4(lanes(this), lanes(&result), 1);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x4::normalise()
+{
+	table()->unit4(lanes(this), lanes(this), 1);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x4 Vector3x4::projection(const Vector3x4& t_onto) const
+{
+	Vector3x4 result;
+	table()->project4(lanes(this), lanes(&t_onto), lanes(&result), 1, false);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x4 Vector3x4::rejection(const Vector3x4& t_onto) const
+{
+	Vector3x4 result;
+	table()->project4(lanes(this), lanes(&t_onto), lanes(&result), 1, true);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x4::dot(const Vector3x4* t_left, const Vector3x4* t_right, float* t_result, const size_t t_count)
+{
+	table()->dot4(lanes(t_left), lanes(t_right), t_result, t_count);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x4::crossProduct(const Vector3x4* t_left, const Vector3x4* t_right, Vector3x4* t_result, const size_t t_count)
+{
+	table()->cross4(lanes(t_left), lanes(t_right), lanes(t_result), t_count);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x4::unit(const Vector3x4* t_vectors, Vector3x4* t_result, const size_t t_count)
+{
+	table()->unit4(lanes(t_vectors), lanes(t_result), t_count);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x4::projection(const Vector3x4* t_vectors, const Vector3x4* t_onto, Vector3x4* t_result, const size_t t_count)
+{
+	table()->project4(lanes(t_vectors), lanes(t_onto), lanes(t_result), t_count, false);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x4::rejection(const Vector3x4* t_vectors, const Vector3x4* t_onto, Vector3x4* t_result, const size_t t_count)
+{
+	table()->project4(lanes(t_vectors), lanes(t_onto), lanes(t_result), t_count, true);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x8 Vector3x8::load(const Vector3* t_vectors, const size_t t_count)
+{
+	Vector3x8 packet;
+
+	for (size_t i = 0; i < WIDTH; i++)
+	{
+		bool used = i < t_count;
+		packet.x[i] = used ? t_vectors[i].x : 0.0f;
+		packet.y[i] = used ? t_vectors[i].y : 0.0f;
+		packet.z[i] = used ? t_vectors[i].z : 0.0f;
+	}
+
+	return packet;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x8::store(Vector3* t_vectors, const size_t t_count) const
+{
+	for (size_t i = 0; i < t_count && i < WIDTH; i++)
+	{
+		t_vectors[i] = Vector3(x[i], y[i], z[i]);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x8::dot(const Vector3x8& t_other, float t_result[WIDTH]) const
+{
+	table()->dot8(lanes(this), lanes(&t_other), t_result, 1);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x8 Vector3x8::crossProduct(const Vector3x8& t_other) const
+{
+	Vector3x8 result;
+	table()->cross8(lanes(this), lanes(&t_other), lanes(&result), 1);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x8 Vector3x8::unit() const
+{
+	Vector3x8 result;
+	table()->unit8(lanes(this), lanes(&result), 1);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x8::normalise()
+{
+	table()->unit8(lanes(this), lanes(this), 1);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x8 Vector3x8::projection(const Vector3x8& t_onto) const
+{
+	Vector3x8 result;
+	table()->project8(lanes(this), lanes(&t_onto), lanes(&result), 1, false);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+Vector3x8 Vector3x8::rejection(const Vector3x8& t_onto) const
+{
+	Vector3x8 result;
+	table()->project8(lanes(this), lanes(&t_onto), lanes(&result), 1, true);
+	return result;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x8::dot(const Vector3x8* t_left, const Vector3x8* t_right, float* t_result, const size_t t_count)
+{
+	table()->dot8(lanes(t_left), lanes(t_right), t_result, t_count);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x8::crossProduct(const Vector3x8* t_left, const Vector3x8* t_right, Vector3x8* t_result, const size_t t_count)
+{
+	table()->cross8(lanes(t_left), lanes(t_right), lanes(t_result), t_count);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x8::unit(const Vector3x8* t_vectors, Vector3x8* t_result, const size_t t_count)
+{
+	table()->unit8(lanes(t_vectors), lanes(t_result), t_count);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x8::projection(const Vector3x8* t_vectors, const Vector3x8* t_onto, Vector3x8* t_result, const size_t t_count)
+{
+	table()->project8(lanes(t_vectors), lanes(t_onto), lanes(t_result), t_count, false);
+}
+
+///////////////////////////////////////////////////////////////////////
+
+void Vector3x8::rejection(const Vector3x8* t_vectors, const Vector3x8* t_onto, Vector3x8* t_result, const size_t t_count)
+{
+	table()->project8(lanes(t_vectors), lanes(t_onto), lanes(t_result), t_count, true);
+}
@@ -0,0 +1,106 @@
+#ifndef MY_VECTOR_PACKET
+#define MY_VECTOR_PACKET
+#include "Vector3.h"
+#include <cstddef>
+
+namespace gpp
+{
+	/// <summary>
+	/// Instruction sets the packet kernels can be dispatched to, in increasing order
+	/// </summary>
+	enum SimdLevel
+	{
+		SIMD_SCALAR,
+		SIMD_SSE41,
+		SIMD_AVX2,
+		SIMD_AVX512
+	};
+
+	namespace Simd
+	{
+		/// <summary>
+		/// @brief Highest level supported by both the CPU (CPUID) and the OS (XGETBV)
+		/// </summary>
+		SimdLevel detect();
+
+		/// <summary>
+		/// @brief Level the packet operations currently dispatch to, detect() by default
+		/// </summary>
+		SimdLevel active();
+
+		/// <summary>
+		/// @brief Dispatch to a lower level, e.g. to compare paths. Clamped to detect().
+		/// </summary>
+		void setLevel(const SimdLevel t_level);
+
+		const char* name(const SimdLevel t_level);
+	}
+
+	/// <summary>
+	/// Four Vector3s in structure-of-arrays lanes. Every operation applies the
+	/// matching Vector3 operation to each lane and matches its results.
+	/// </summary>
+	struct alignas(16) Vector3x4
+	{
+		static const int WIDTH = 4;
+
+		float x[WIDTH];
+		float y[WIDTH];
+		float z[WIDTH];
+
+		/// <summary>
+		/// @brief Load up to four vectors, unused lanes are zeroed
+		/// </summary>
+		static Vector3x4 load(const Vector3* t_vectors, const size_t t_count = WIDTH);
+
+		/// <summary>
+		/// @brief Store the first t_count lanes back to an array of vectors
+		/// </summary>
+		void store(Vector3* t_vectors, const size_t t_count = WIDTH) const;
+
+		void dot(const Vector3x4& t_other, float t_result[WIDTH]) const;
+		Vector3x4 crossProduct(const Vector3x4& t_other) const;
+		Vector3x4 unit() const;
+		void normalise();
+		Vector3x4 projection(const Vector3x4& t_onto) const;
+		Vector3x4 rejection(const Vector3x4& t_onto) const;
+
+		/// <summary>
+		/// @brief Bulk versions over arrays of packets; dispatch happens once per call
+		/// </summary>
+		static void dot(const Vector3x4* t_left, const Vector3x4* t_right, float* t_result, const size_t t_count);
+		static void crossProduct(const Vector3x4* t_left, const Vector3x4* t_right, Vector3x4* t_result, const size_t t_count);
+		static void unit(const Vector3x4* t_vectors, Vector3x4* t_result, const size_t t_count);
+		static void projection(const Vector3x4* t_vectors, const Vector3x4* t_onto, Vector3x4* t_result, const size_t t_count);
+		static void rejection(const Vector3x4* t_vectors, const Vector3x4* t_onto, Vector3x4* t_result, const size_t t_count);
+	};
+
+	/// <summary>
+	/// Eight Vector3s in structure-of-arrays lanes, see Vector3x4
+	/// </summary>
+	struct alignas(32) Vector3x8
+	{
+		static const int WIDTH = 8;
+
+		float x[WIDTH];
+		float y[WIDTH];
+		float z[WIDTH];
+
+		static Vector3x8 load(const Vector3* t_vectors, const size_t t_count = WIDTH);
+		void store(Vector3* t_vectors, const size_t t_count = WIDTH) const;
+
+		void dot(const Vector3x8& t_other, float t_result[WIDTH]) const;
+		Vector3x8 crossProduct(const Vector3x8& t_other) const;
+		Vector3x8 unit() const;
+		void normalise();
+		Vector3x8 projection(const Vector3x8& t_onto) const;
+		Vector3x8 rejection(const Vector3x8& t_onto) const;
+
+		static void dot(const Vector3x8* t_left, const Vector3x8* t_right, float* t_result, const size_t t_count);
+		static void crossProduct(const Vector3x8* t_left, const Vector3x8* t_right, Vector3x8* t_result, const size_t t_count);
+		static void unit(const Vector3x8* t_vectors, Vector3x8* t_result, const size_t t_count);
+		static void projection(const Vector3x8* t_vectors, const Vector3x8* t_onto, Vector3x8* t_result, const size_t t_count);
+		static void rejection(const Vector3x8* t_vectors, const Vector3x8* t_onto, Vector3x8* t_result, const size_t t_count);
+	};
+}
+#endif // !MY_VECTOR_PACKET
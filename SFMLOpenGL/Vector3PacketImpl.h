@@ -0,0 +1,201 @@
+#ifndef MY_VECTOR_PACKET_IMPL
+#define MY_VECTOR_PACKET_IMPL
+#include "Vector3Packet.h"
+
+// Internal to the Vector3Packet translation units: the kernel algorithms are
+// written once against a register wrapper V and instantiated per instruction set.
+//
+// V provides: WIDTH, Mask, load, store, loadSplit, storeSplit, add, sub, mul,
+// div, sqrt, zero, greaterThanZero, notZero and select.
+
+namespace gpp
+{
+	namespace PacketKernels
+	{
+		typedef void(*DotFn)(const float*, const float*, float*, size_t);
+		typedef void(*CrossFn)(const float*, const float*, float*, size_t);
+		typedef void(*UnitFn)(const float*, float*, size_t);
+		typedef void(*ProjectFn)(const float*, const float*, float*, size_t, bool);
+
+		/// <summary>
+		/// Kernels for one instruction set. Pointers are to arrays of packets,
+		/// counts are in packets, and lanes are laid out x[W] y[W] z[W] per packet.
+		/// </summary>
+		struct Table
+		{
+			DotFn dot4;
+			CrossFn cross4;
+			UnitFn unit4;
+			ProjectFn project4; // rejection when the flag is set
+			DotFn dot8;
+			CrossFn cross8;
+			UnitFn unit8;
+			ProjectFn project8;
+		};
+
+		const Table& scalarTable();
+		const Table& sse41Table();
+		const Table& avx2Table();
+		const Table& avx512Table();
+
+		/// <summary>
+		/// Algorithms over packets of W lanes with V::WIDTH lanes per step.
+		/// When V::WIDTH is 2W each step covers two packets, and the process
+		/// functions return how many packets they handled so a narrower
+		/// table can finish the remainder.
+		/// </summary>
+		template <class V, int W>
+		struct Kernels
+		{
+			static const int STEP = V::WIDTH;
+			static const int PACKETS_PER_STEP = (STEP > W) ? STEP / W : 1;
+
+			static size_t offset(size_t t_lane, int t_component)
+			{
+				return (t_lane / W) * 3 * W + t_component * W + t_lane % W;
+			}
+
+			static V load(const float* t_base, size_t t_lane, int t_component)
+			{
+				return (STEP > W)
+					? V::loadSplit(t_base + offset(t_lane, t_component), t_base + offset(t_lane + W, t_component))
+					: V::load(t_base + offset(t_lane, t_component));
+			}
+
+			static void store(float* t_base, size_t t_lane, int t_component, V t_value)
+			{
+				if (STEP > W)
+				{
+					V::storeSplit(t_base + offset(t_lane, t_component), t_base + offset(t_lane + W, t_component), t_value);
+				}
+				else
+				{
+					V::store(t_base + offset(t_lane, t_component), t_value);
+				}
+			}
+
+			static size_t steps(size_t t_count)
+			{
+				return t_count / PACKETS_PER_STEP;
+			}
+
+			static size_t dot(const float* t_a, const float* t_b, float* t_out, size_t t_count)
+			{
+				size_t lanes = steps(t_count) * PACKETS_PER_STEP * W;
+
+				for (size_t lane = 0; lane < lanes; lane += STEP)
+				{
+					V d = V::add(V::add(V::mul(load(t_a, lane, 0), load(t_b, lane, 0)),
+						V::mul(load(t_a, lane, 1), load(t_b, lane, 1))),
+						V::mul(load(t_a, lane, 2), load(t_b, lane, 2)));
+					V::store(t_out + lane, d); // results are contiguous
+				}
+
+				return lanes / W;
+			}
+
+			static size_t cross(const float* t_a, const float* t_b, float* t_out, size_t t_count)
+			{
+				size_t lanes = steps(t_count) * PACKETS_PER_STEP * W;
+
+				for (size_t lane = 0; lane < lanes; lane += STEP)
+				{
+					V ax = load(t_a, lane, 0), ay = load(t_a, lane, 1), az = load(t_a, lane, 2);
+					V bx = load(t_b, lane, 0), by = load(t_b, lane, 1), bz = load(t_b, lane, 2);
+
+					store(t_out, lane, 0, V::sub(V::mul(ay, bz), V::mul(az, by)));
+					store(t_out, lane, 1, V::sub(V::mul(az, bx), V::mul(ax, bz)));
+					store(t_out, lane, 2, V::sub(V::mul(ax, by), V::mul(ay, bx)));
+				}
+
+				return lanes / W;
+			}
+
+			static size_t unit(const float* t_a, float* t_out, size_t t_count)
+			{
+				size_t lanes = steps(t_count) * PACKETS_PER_STEP * W;
+
+				for (size_t lane = 0; lane < lanes; lane += STEP)
+				{
+					V x = load(t_a, lane, 0), y = load(t_a, lane, 1), z = load(t_a, lane, 2);
+					V magnitude = V::sqrt(V::add(V::add(V::mul(x, x), V::mul(y, y)), V::mul(z, z)));
+					typename V::Mask nonZero = V::greaterThanZero(magnitude); // don't divide by 0!
+
+					store(t_out, lane, 0, V::select(nonZero, V::div(x, magnitude), x));
+					store(t_out, lane, 1, V::select(nonZero, V::div(y, magnitude), y));
+					store(t_out, lane, 2, V::select(nonZero, V::div(z, magnitude), z));
+				}
+
+				return lanes / W;
+			}
+
+			static size_t project(const float* t_a, const float* t_onto, float* t_out, size_t t_count, bool t_reject)
+			{
+				size_t lanes = steps(t_count) * PACKETS_PER_STEP * W;
+
+				for (size_t lane = 0; lane < lanes; lane += STEP)
+				{
+					V ux = load(t_a, lane, 0), uy = load(t_a, lane, 1), uz = load(t_a, lane, 2);
+					V vx = load(t_onto, lane, 0), vy = load(t_onto, lane, 1), vz = load(t_onto, lane, 2);
+
+					V dotProduct = V::add(V::add(V::mul(ux, vx), V::mul(uy, vy)), V::mul(uz, vz));
+					V magnitude = V::sqrt(V::add(V::add(V::mul(vx, vx), V::mul(vy, vy)), V::mul(vz, vz)));
+					typename V::Mask positive = V::greaterThanZero(magnitude);
+					typename V::Mask nonZero = V::notZero(magnitude);
+					V scale = V::div(dotProduct, magnitude);
+
+					// projection = unit(v) * (u.v / |v|), or null when |v| is zero
+					V px = V::select(nonZero, V::mul(V::select(positive, V::div(vx, magnitude), vx), scale), V::zero());
+					V py = V::select(nonZero, V::mul(V::select(positive, V::div(vy, magnitude), vy), scale), V::zero());
+					V pz = V::select(nonZero, V::mul(V::select(positive, V::div(vz, magnitude), vz), scale), V::zero());
+
+					if (t_reject)
+					{
+						px = V::sub(ux, px), py = V::sub(uy, py), pz = V::sub(uz, pz); // w = u - u1
+					}
+
+					store(t_out, lane, 0, px);
+					store(t_out, lane, 1, py);
+					store(t_out, lane, 2, pz);
+				}
+
+				return lanes / W;
+			}
+		};
+
+		/// <summary>
+		/// Table entry points for one instruction set. Packets the kernels
+		/// leave over are handed to the FALLBACK table.
+		/// </summary>
+		template <class V, int W, const Table& (*FALLBACK)()>
+		struct Entry
+		{
+			static const size_t STRIDE = 3 * W; // floats per packet
+
+			static void dot(const float* t_a, const float* t_b, float* t_out, size_t t_count)
+			{
+				size_t done = Kernels<V, W>::dot(t_a, t_b, t_out, t_count);
+				if (done < t_count) (W == 4 ? FALLBACK().dot4 : FALLBACK().dot8)(t_a + done * STRIDE, t_b + done * STRIDE, t_out + done * W, t_count - done);
+			}
+
+			static void cross(const float* t_a, const float* t_b, float* t_out, size_t t_count)
+			{
+				size_t done = Kernels<V, W>::cross(t_a, t_b, t_out, t_count);
+				if (done < t_count) (W == 4 ? FALLBACK().cross4 : FALLBACK().cross8)(t_a + done * STRIDE, t_b + done * STRIDE, t_out + done * STRIDE, t_count - done);
+			}
+
+			static void unit(const float* t_a, float* t_out, size_t t_count)
+			{
+				size_t done = Kernels<V, W>::unit(t_a, t_out, t_count);
+				if (done < t_count) (W == 4 ? FALLBACK().unit4 : FALLBACK().unit8)(t_a + done * STRIDE, t_out + done * STRIDE, t_count - done);
+			}
+
+			static void project(const float* t_a, const float* t_onto, float* t_out, size_t t_count, bool t_reject)
+			{
+				size_t done = Kernels<V, W>::project(t_a, t_onto, t_out, t_count, t_reject);
+				if (done < t_count) (W == 4 ? FALLBACK().project4 : FALLBACK().project8)(t_a + done * STRIDE, t_onto + done * STRIDE, t_out + done * STRIDE, t_count - done, t_reject);
+			}
+		};
+	}
+}
+#endif // !MY_VECTOR_PACKET_IMPL
@@ -0,0 +1,78 @@
+#include "Vector3Packet.h"
+#include <immintrin.h>
+
+// MSVC accepts intrinsics without /arch; GCC needs the target enabled for this file only
+#if defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+
+#include "Vector3PacketImpl.h"
+
+using namespace gpp;
+
+namespace
+{
+	/// <summary>
+	/// Four-lane VEX-encoded register, used for Vector3x4 packets
+	/// </summary>
+	struct Avx128V
+	{
+		static const int WIDTH = 4;
+		typedef Avx128V Mask;
+
+		__m128 r;
+
+		static Avx128V make(__m128 t_r) { Avx128V v; v.r = t_r; return v; }
+		static Avx128V load(const float* t_p) { return make(_mm_loadu_ps(t_p)); }
+		static void store(float* t_p, Avx128V t_v) { _mm_storeu_ps(t_p, t_v.r); }
+		static Avx128V loadSplit(const float* t_low, const float*) { return load(t_low); }
+		static void storeSplit(float* t_low, float*, Avx128V t_v) { store(t_low, t_v); }
+		static Avx128V add(Avx128V t_a, Avx128V t_b) { return make(_mm_add_ps(t_a.r, t_b.r)); }
+		static Avx128V sub(Avx128V t_a, Avx128V t_b) { return make(_mm_sub_ps(t_a.r, t_b.r)); }
+		static Avx128V mul(Avx128V t_a, Avx128V t_b) { return make(_mm_mul_ps(t_a.r, t_b.r)); }
+		static Avx128V div(Avx128V t_a, Avx128V t_b) { return make(_mm_div_ps(t_a.r, t_b.r)); }
+		static Avx128V sqrt(Avx128V t_a) { return make(_mm_sqrt_ps(t_a.r)); }
+		static Avx128V zero() { return make(_mm_setzero_ps()); }
+		static Mask greaterThanZero(Avx128V t_a) { return make(_mm_cmp_ps(t_a.r, _mm_setzero_ps(), _CMP_GT_OQ)); }
+		static Mask notZero(Avx128V t_a) { return make(_mm_cmp_ps(t_a.r, _mm_setzero_ps(), _CMP_NEQ_UQ)); }
+		static Avx128V select(Mask t_mask, Avx128V t_a, Avx128V t_b) { return make(_mm_blendv_ps(t_b.r, t_a.r, t_mask.r)); }
+	};
+
+	/// <summary>
+	/// Eight-lane AVX register, used for Vector3x8 packets
+	/// </summary>
+	struct Avx256V
+	{
+		static const int WIDTH = 8;
+		typedef Avx256V Mask;
+
+		__m256 r;
+
+		static Avx256V make(__m256 t_r) { Avx256V v; v.r = t_r; return v; }
+		static Avx256V load(const float* t_p) { return make(_mm256_loadu_ps(t_p)); }
+		static void store(float* t_p, Avx256V t_v) { _mm256_storeu_ps(t_p, t_v.r); }
+		static Avx256V loadSplit(const float* t_low, const float*) { return load(t_low); }
+		static void storeSplit(float* t_low, float*, Avx256V t_v) { store(t_low, t_v); }
+		static Avx256V add(Avx256V t_a, Avx256V t_b) { return make(_mm256_add_ps(t_a.r, t_b.r)); }
+		static Avx256V sub(Avx256V t_a, Avx256V t_b) { return make(_mm256_sub_ps(t_a.r, t_b.r)); }
+		static Avx256V mul(Avx256V t_a, Avx256V t_b) { return make(_mm256_mul_ps(t_a.r, t_b.r)); }
+		static Avx256V div(Avx256V t_a, Avx256V t_b) { return make(_mm256_div_ps(t_a.r, t_b.r)); }
+		static Avx256V sqrt(Avx256V t_a) { return make(_mm256_sqrt_ps(t_a.r)); }
+		static Avx256V zero() { return make(_mm256_setzero_ps()); }
+		static Mask greaterThanZero(Avx256V t_a) { return make(_mm256_cmp_ps(t_a.r, _mm256_setzero_ps(), _CMP_GT_OQ)); }
+		static Mask notZero(Avx256V t_a) { return make(_mm256_cmp_ps(t_a.r, _mm256_setzero_ps(), _CMP_NEQ_UQ)); }
+		static Avx256V select(Mask t_mask, Avx256V t_a, Avx256V t_b) { return make(_mm256_blendv_ps(t_b.r, t_a.r, t_mask.r)); }
+	};
+}
+
+const PacketKernels::Table& PacketKernels::avx2Table()
+{
+	static const Table table = {
+		&Entry<Avx128V, 4, scalarTable>::dot, &Entry<Avx128V, 4, scalarTable>::cross,
+		&Entry<Avx128V, 4, scalarTable>::unit, &Entry<Avx128V, 4, scalarTable>::project,
+		&Entry<Avx256V, 8, scalarTable>::dot, &Entry<Avx256V, 8, scalarTable>::cross,
+		&Entry<Avx256V, 8, scalarTable>::unit, &Entry<Avx256V, 8, scalarTable>::project
+	};
+
+	return table;
+}
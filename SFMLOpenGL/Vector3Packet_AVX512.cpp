@@ -0,0 +1,68 @@
+#include "Vector3Packet.h"
+#include <immintrin.h>
+
+// MSVC accepts intrinsics without /arch; GCC needs the target enabled for this file only
+#if defined(__GNUC__)
+#pragma GCC target("avx512f")
+#pragma GCC optimize("fp-contract=off") // avx512f implies FMA; keep results identical to the scalar Vector3
+#endif
+
+#include "Vector3PacketImpl.h"
+
+using namespace gpp;
+
+namespace
+{
+	/// <summary>
+	/// Sixteen-lane AVX-512 register. Each step covers two Vector3x8 packets,
+	/// loading the same component of each into the low and high halves.
+	/// </summary>
+	struct Avx512V
+	{
+		static const int WIDTH = 16;
+		typedef __mmask16 Mask;
+
+		__m512 r;
+
+		static Avx512V make(__m512 t_r) { Avx512V v; v.r = t_r; return v; }
+		static Avx512V load(const float* t_p) { return make(_mm512_loadu_ps(t_p)); }
+		static void store(float* t_p, Avx512V t_v) { _mm512_storeu_ps(t_p, t_v.r); }
+
+		static Avx512V loadSplit(const float* t_low, const float* t_high)
+		{
+			__m512d low = _mm512_castpd256_pd512(_mm256_castps_pd(_mm256_loadu_ps(t_low)));
+			return make(_mm512_castpd_ps(_mm512_insertf64x4(low, _mm256_castps_pd(_mm256_loadu_ps(t_high)), 1)));
+		}
+
+		static void storeSplit(float* t_low, float* t_high, Avx512V t_v)
+		{
+			_mm256_storeu_ps(t_low, _mm512_castps512_ps256(t_v.r));
+			_mm256_storeu_ps(t_high, _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(t_v.r), 1)));
+		}
+
+		static Avx512V add(Avx512V t_a, Avx512V t_b) { return make(_mm512_add_ps(t_a.r, t_b.r)); }
+		static Avx512V sub(Avx512V t_a, Avx512V t_b) { return make(_mm512_sub_ps(t_a.r, t_b.r)); }
+		static Avx512V mul(Avx512V t_a, Avx512V t_b) { return make(_mm512_mul_ps(t_a.r, t_b.r)); }
+		static Avx512V div(Avx512V t_a, Avx512V t_b) { return make(_mm512_div_ps(t_a.r, t_b.r)); }
+		static Avx512V sqrt(Avx512V t_a) { return make(_mm512_sqrt_ps(t_a.r)); }
+		static Avx512V zero() { return make(_mm512_setzero_ps()); }
+		static Mask greaterThanZero(Avx512V t_a) { return _mm512_cmp_ps_mask(t_a.r, _mm512_setzero_ps(), _CMP_GT_OQ); }
+		static Mask notZero(Avx512V t_a) { return _mm512_cmp_ps_mask(t_a.r, _mm512_setzero_ps(), _CMP_NEQ_UQ); }
+		static Avx512V select(Mask t_mask, Avx512V t_a, Avx512V t_b) { return make(_mm512_mask_blend_ps(t_mask, t_b.r, t_a.r)); }
+	};
+}
+
+/// <summary>
+/// Vector3x8 packets are processed in pairs, an odd packet out falls back to AVX2.
+/// Vector3x4 packets gain nothing from the wider registers and use the AVX2 kernels.
+/// </summary>
+const PacketKernels::Table& PacketKernels::avx512Table()
+{
+	static const Table table = {
+		avx2Table().dot4, avx2Table().cross4, avx2Table().unit4, avx2Table().project4,
+		&Entry<Avx512V, 8, avx2Table>::dot, &Entry<Avx512V, 8, avx2Table>::cross,
+		&Entry<Avx512V, 8, avx2Table>::unit, &Entry<Avx512V, 8, avx2Table>::project
+	};
+
+	return table;
+}
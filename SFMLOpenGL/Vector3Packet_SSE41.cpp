@@ -0,0 +1,52 @@
+#include "Vector3Packet.h"
+#include <immintrin.h>
+
+// MSVC accepts intrinsics without /arch; GCC needs the target enabled for this file only
+#if defined(__GNUC__)
+#pragma GCC target("sse4.1")
+#endif
+
+#include "Vector3PacketImpl.h"
+
+using namespace gpp;
+
+namespace
+{
+	/// <summary>
+	/// Four-lane SSE register
+	/// </summary>
+	struct SseV
+	{
+		static const int WIDTH = 4;
+		typedef SseV Mask;
+
+		__m128 r;
+
+		static SseV make(__m128 t_r) { SseV v; v.r = t_r; return v; }
+		static SseV load(const float* t_p) { return make(_mm_loadu_ps(t_p)); }
+		static void store(float* t_p, SseV t_v) { _mm_storeu_ps(t_p, t_v.r); }
+		static SseV loadSplit(const float* t_low, const float*) { return load(t_low); }
+		static void storeSplit(float* t_low, float*, SseV t_v) { store(t_low, t_v); }
+		static SseV add(SseV t_a, SseV t_b) { return make(_mm_add_ps(t_a.r, t_b.r)); }
+		static SseV sub(SseV t_a, SseV t_b) { return make(_mm_sub_ps(t_a.r, t_b.r)); }
+		static SseV mul(SseV t_a, SseV t_b) { return make(_mm_mul_ps(t_a.r, t_b.r)); }
+		static SseV div(SseV t_a, SseV t_b) { return make(_mm_div_ps(t_a.r, t_b.r)); }
+		static SseV sqrt(SseV t_a) { return make(_mm_sqrt_ps(t_a.r)); }
+		static SseV zero() { return make(_mm_setzero_ps()); }
+		static Mask greaterThanZero(SseV t_a) { return make(_mm_cmpgt_ps(t_a.r, _mm_setzero_ps())); }
+		static Mask notZero(SseV t_a) { return make(_mm_cmpneq_ps(t_a.r, _mm_setzero_ps())); }
+		static SseV select(Mask t_mask, SseV t_a, SseV t_b) { return make(_mm_blendv_ps(t_b.r, t_a.r, t_mask.r)); }
+	};
+}
+
+const PacketKernels::Table& PacketKernels::sse41Table()
+{
+	static const Table table = {
+		&Entry<SseV, 4, scalarTable>::dot, &Entry<SseV, 4, scalarTable>::cross,
+		&Entry<SseV, 4, scalarTable>::unit, &Entry<SseV, 4, scalarTable>::project,
+		&Entry<SseV, 8, scalarTable>::dot, &Entry<SseV, 8, scalarTable>::cross,
+		&Entry<SseV, 8, scalarTable>::unit, &Entry<SseV, 8, scalarTable>::project
+	};
+
+	return table;
+}